@@ -0,0 +1,127 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_BINARY_DUMP_HPP_
+#define HANDYSTATS_BINARY_DUMP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <map>
+
+#include <handystats/statistics.hpp>
+#include <handystats/metrics.hpp>
+#include <handystats/metrics/attribute.hpp>
+#include <handystats/metrics_dump.hpp>
+
+/*
+ * Compact binary snapshot format of metrics dump.
+ *
+ * snapshot ::= "HSTB" <version : byte> <timestamp : varint> <metrics count : varint> { <metric> }
+ *
+ * metric ::= <name> <type : byte> (<statistics> | <attribute value>)
+ * name ::= <shared prefix length : varint> <suffix length : varint> <suffix bytes>
+ *     (metrics are sorted by name, so each name shares prefix with the previous one)
+ *
+ * statistics ::= <tags : varint> { <value> }
+ *     values of enabled tags in ascending order of tag bits,
+ *     histogram ::= <bins count : varint> { <center : double> <count : double> },
+ *     quantile ::= <p25> <p50> <p75> <p90> <p95> (doubles),
+ *     timestamp ::= <msec delta from snapshot timestamp : signed varint>
+ *
+ * attribute value ::= <value index : byte> <value>
+ *     bool as byte, integers as (signed) varints, string as <length : varint> <bytes>
+ *
+ * varint is LEB128, signed varint is zigzag-encoded varint.
+ * double ::= <varint> where
+ *     (n << 1) for integral values n (|n| < 2^53, n zigzag-encoded),
+ *     1 followed by 8 bytes of IEEE 754 little-endian representation otherwise.
+ *
+ * Timestamps are in msec since epoch.
+ */
+
+namespace handystats { namespace binary {
+
+static const char MAGIC[4] = {'H', 'S', 'T', 'B'};
+static const uint8_t VERSION = 1;
+
+std::string to_string(const std::map<std::string, handystats::metrics::metric_variant>&);
+
+// Appends serialized dump to the buffer
+void write_to_string(const std::map<std::string, handystats::metrics::metric_variant>&, std::string& buffer);
+
+// Writes serialized dump to file descriptor through fixed-size buffer, returns false on write error
+bool write_to_fd(const std::map<std::string, handystats::metrics::metric_variant>&, const int& fd);
+
+
+/*
+ * Reader
+ */
+
+struct metric_record {
+	metrics::metric_index type;
+
+	// statistics (gauge, counter, timer)
+	statistics::tag::type tags;
+
+	double value;
+	double min;
+	double max;
+	uint64_t count;
+	double sum;
+	double avg;
+	double moving_count;
+	double moving_sum;
+	double moving_avg;
+	std::vector<std::pair<double, double>> histogram;
+	std::vector<std::pair<double, double>> quantiles;
+	int64_t timestamp;
+	double rate;
+	double entropy;
+
+	// attribute
+	metrics::attribute::value_type attribute_value;
+
+	metric_record();
+};
+
+struct snapshot {
+	uint8_t version;
+	int64_t timestamp;
+	std::map<std::string, metric_record> metrics;
+
+	snapshot();
+};
+
+// returns false if data is malformed or has unsupported version
+bool decode(const char* data, const size_t& size, snapshot& result);
+bool decode(const std::string& data, snapshot& result);
+
+}} // namespace handystats::binary
+
+std::string HANDY_BINARY_DUMP();
+
+/*
+ * Shared immutable binary dump rendered once per dump interval.
+ * Dump is rendered on dump update if "binary" is listed in "dump-formats" configuration option,
+ * otherwise it is rendered on first call and shared by later calls until next dump.
+ */
+std::shared_ptr<const std::string> HANDY_BINARY_DUMP_SHARED();
+
+#endif // HANDYSTATS_BINARY_DUMP_HPP_
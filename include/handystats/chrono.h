@@ -22,6 +22,12 @@
 
 #include <handystats/common.h>
 
+/*
+ * TSC frequency used to convert handystats_now() values is refined
+ * by handystats core's processing thread.
+ * Without HANDY_INIT the provisional frequency taken on first conversion
+ * (CPUID, nominal frequency from /proc/cpuinfo or single 1ms measurement) is kept.
+ */
 HANDYSTATS_EXTERN_C
 int64_t handystats_now(void);
 
@@ -95,6 +95,13 @@ struct system_clock {
 	static time_point now();
 };
 
+struct coarse_clock {
+	// will return tsc_clock's time_point cached by handystats core,
+	// refreshed every 50 microseconds while coarse timestamps are configured
+	// falls back to tsc_clock::now() otherwise
+	static time_point now();
+};
+
 struct duration {
 	static duration convert_to(const time_unit&, const duration&);
 
@@ -25,6 +25,8 @@
 namespace handystats { namespace config { namespace metrics {
 
 struct gauge {
+	// events are timestamped with chrono::coarse_clock instead of chrono::tsc_clock
+	bool coarse_timestamp;
 	statistics values;
 
 	gauge();
@@ -45,7 +45,8 @@
  *         }
  *     },
  *     "metrics-dump": {
- *         "interval": <value in msec>
+ *         "interval": <value in msec>,
+ *         "formats": ["json" | "prometheus" | "binary", ...]
  *     },
  *     "<pattern>": {
  *         <statistics opts>
@@ -58,6 +59,24 @@
  * {
  *     "enable": <boolean value>,
  *     "dump-interval": <value in msec>,
+ *     "dump-formats": ["json" | "prometheus" | "binary", ...],
+ *     "dump-filter": {
+ *         "<pattern>": ["<tag name>", ...],
+ *         ...
+ *     },
+ *     "shm-export": {
+ *         "name": "<shared memory object name, %p is replaced with pid>",
+ *         "size": <initial size in bytes>
+ *     },
+ *     "push-export": {
+ *         "address": <"unix:<socket path>" | "udp:<host>:<port>">,
+ *         "buffer-size": <max unsent data in bytes>,
+ *         "max-datagram-size": <value in bytes>
+ *     },
+ *     "registry": {
+ *         "ttl": <idle time in msec before metric is evicted>,
+ *         "max-size": <max number of metrics>
+ *     },
  *     "defaults": {
  *         "moving-interval": <value in msec>,
  *         "histogram-bins": <integer value>,
@@ -65,9 +84,11 @@
  *         "rate-unit": <"ns" | "us" | "ms" | "s" | "m" | "h">
  *     },
  *     "gauge": {
+ *         "timestamp": <"precise" | "coarse">,
  *         <statistics opts>
  *     },
  *     "counter": {
+ *         "timestamp": <"precise" | "coarse">,
  *         <statistics opts>
  *     },
  *     "timer": {
@@ -75,6 +96,7 @@
  *         <statistics opts>
  *     },
  *     "<pattern>": {
+ *         "max-metrics": <max number of metrics matching pattern>,
  *         <statistics opts>
  *     }
  * }
@@ -18,6 +18,7 @@
 #ifndef HANDYSTATS_CORE_HPP_
 #define HANDYSTATS_CORE_HPP_
 
+#include <handystats/atomic.hpp>
 #include <handystats/rapidjson/document.h>
 
 /*
@@ -45,7 +46,8 @@
  *         }
  *     },
  *     "metrics-dump": {
- *         "interval": <value in msec>
+ *         "interval": <value in msec>,
+ *         "formats": ["json" | "prometheus" | "binary", ...]
  *     },
  *     "<pattern>": {
  *         <statistics opts>
@@ -58,6 +60,24 @@
  * {
  *     "enable": <boolean value>,
  *     "dump-interval": <value in msec>,
+ *     "dump-formats": ["json" | "prometheus" | "binary", ...],
+ *     "dump-filter": {
+ *         "<pattern>": ["<tag name>", ...],
+ *         ...
+ *     },
+ *     "shm-export": {
+ *         "name": "<shared memory object name, %p is replaced with pid>",
+ *         "size": <initial size in bytes>
+ *     },
+ *     "push-export": {
+ *         "address": <"unix:<socket path>" | "udp:<host>:<port>">,
+ *         "buffer-size": <max unsent data in bytes>,
+ *         "max-datagram-size": <value in bytes>
+ *     },
+ *     "registry": {
+ *         "ttl": <idle time in msec before metric is evicted>,
+ *         "max-size": <max number of metrics>
+ *     },
  *     "defaults": {
  *         "moving-interval": <value in msec>,
  *         "histogram-bins": <integer value>,
@@ -65,9 +85,11 @@
  *         "rate-unit": <"ns" | "us" | "ms" | "s" | "m" | "h">
  *     },
  *     "gauge": {
+ *         "timestamp": <"precise" | "coarse">,
  *         <statistics opts>
  *     },
  *     "counter": {
+ *         "timestamp": <"precise" | "coarse">,
  *         <statistics opts>
  *     },
  *     "timer": {
@@ -75,6 +97,7 @@
  *         <statistics opts>
  *     },
  *     "<pattern>": {
+ *         "max-metrics": <max number of metrics matching pattern>,
  *         <statistics opts>
  *     }
  * }
@@ -82,6 +105,23 @@
 
 namespace handystats {
 
+/*
+ * Runtime enabled flag.
+ * Changed only on initialization and finalization, but read by each measuring point,
+ * so it occupies whole cache line and is read with relaxed ordering.
+ */
+struct enabled_flag_type : std::atomic<bool> {
+	enabled_flag_type(const bool& value)
+		: std::atomic<bool>(value)
+	{}
+} __attribute__((aligned(64)));
+
+extern enabled_flag_type enabled_flag;
+
+inline bool is_enabled() {
+	return enabled_flag.load(std::memory_order_relaxed);
+}
+
 void initialize();
 
 void finalize();
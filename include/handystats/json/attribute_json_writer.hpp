@@ -26,6 +26,7 @@
 #include <handystats/rapidjson/stringbuffer.h>
 #include <handystats/rapidjson/prettywriter.h>
 
+#include <handystats/json/handler.hpp>
 #include <handystats/json/timestamp.hpp>
 #include <handystats/metrics/attribute.hpp>
 
@@ -72,6 +73,49 @@ inline void write_to_json_value(const metrics::attribute* const obj, rapidjson::
 	}
 }
 
+template <typename Handler>
+inline void write_to_json_handler(const metrics::attribute* const obj, Handler& handler) {
+	if (!obj) {
+		handler.Null();
+		return;
+	}
+
+	handler.StartObject();
+
+	write_json_key(handler, "type");
+	handler.String("attribute", 9);
+
+	write_json_key(handler, "value");
+	switch (obj->value().which()) {
+		case metrics::attribute::value_index::BOOL:
+			handler.Bool(boost::get<bool>(obj->value()));
+			break;
+		case metrics::attribute::value_index::INT:
+			handler.Int(boost::get<int>(obj->value()));
+			break;
+		case metrics::attribute::value_index::UINT:
+			handler.Uint(boost::get<unsigned>(obj->value()));
+			break;
+		case metrics::attribute::value_index::INT64:
+			handler.Int64(boost::get<int64_t>(obj->value()));
+			break;
+		case metrics::attribute::value_index::UINT64:
+			handler.Uint64(boost::get<uint64_t>(obj->value()));
+			break;
+		case metrics::attribute::value_index::DOUBLE:
+			handler.Double(boost::get<double>(obj->value()));
+			break;
+		case metrics::attribute::value_index::STRING:
+		{
+			const auto& s = boost::get<std::string>(obj->value());
+			handler.String(s.c_str(), s.size());
+			break;
+		}
+	}
+
+	handler.EndObject();
+}
+
 template<typename StringBuffer, typename Allocator>
 inline void write_to_json_buffer(const metrics::attribute* const obj, StringBuffer* buffer, Allocator& allocator) {
 	rapidjson::Value json_value;
@@ -49,6 +49,27 @@ inline void write_to_json_value(const metrics::gauge* const obj, rapidjson::Valu
 	write_to_json_value(&obj->values(), json_value, allocator);
 }
 
+template <typename Handler>
+inline void write_to_json_handler(
+		const metrics::gauge* const obj, Handler& handler,
+		const statistics::tag::type& tags_filter = ~statistics::tag::empty
+	)
+{
+	if (!obj || (obj->values().tags() & tags_filter) == statistics::tag::empty) {
+		handler.Null();
+		return;
+	}
+
+	handler.StartObject();
+
+	write_json_key(handler, "type");
+	handler.String("gauge", 5);
+
+	write_to_json_handler(&obj->values(), handler, tags_filter);
+
+	handler.EndObject();
+}
+
 template<typename StringBuffer, typename Allocator>
 inline void write_to_json_buffer(const metrics::gauge* const obj, StringBuffer* buffer, Allocator& allocator) {
 	rapidjson::Value json_value;
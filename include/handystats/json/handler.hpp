@@ -0,0 +1,36 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_JSON_HANDLER_HPP_
+#define HANDYSTATS_JSON_HANDLER_HPP_
+
+#include <cstddef>
+
+namespace handystats { namespace json {
+
+/*
+ * Helpers for streaming (SAX) writers.
+ * Handler is rapidjson::Writer-like object (e.g. rapidjson::Writer or rapidjson::PrettyWriter).
+ */
+template <typename Handler, size_t N>
+inline void write_json_key(Handler& handler, const char (&key)[N]) {
+	handler.String(key, N - 1);
+}
+
+}} // namespace handystats::json
+
+#endif // HANDYSTATS_JSON_HANDLER_HPP_
@@ -25,6 +25,7 @@
 #include <handystats/rapidjson/stringbuffer.h>
 #include <handystats/rapidjson/prettywriter.h>
 
+#include <handystats/json/handler.hpp>
 #include <handystats/json/timestamp.hpp>
 #include <handystats/statistics.hpp>
 
@@ -109,6 +110,97 @@ inline void write_to_json_value(const statistics* const obj, rapidjson::Value* j
 	}
 }
 
+/*
+ * Streaming writer, statistics are written as members of currently opened object.
+ * Only statistics both enabled and selected by tags_filter are written.
+ */
+template <typename Handler>
+inline void write_to_json_handler(
+		const statistics* const obj, Handler& handler,
+		const statistics::tag::type& tags_filter = ~statistics::tag::empty
+	)
+{
+	if (!obj) {
+		return;
+	}
+
+	const statistics::tag::type tags = obj->tags() & tags_filter;
+
+	if (tags & statistics::tag::value) {
+		write_json_key(handler, "value");
+		handler.Double(obj->get<statistics::tag::value>());
+	}
+	if (tags & statistics::tag::min) {
+		write_json_key(handler, "min");
+		handler.Double(obj->get<statistics::tag::min>());
+	}
+	if (tags & statistics::tag::max) {
+		write_json_key(handler, "max");
+		handler.Double(obj->get<statistics::tag::max>());
+	}
+	if (tags & statistics::tag::count) {
+		write_json_key(handler, "count");
+		handler.Uint64(obj->get<statistics::tag::count>());
+	}
+	if (tags & statistics::tag::sum) {
+		write_json_key(handler, "sum");
+		handler.Double(obj->get<statistics::tag::sum>());
+	}
+	if (tags & statistics::tag::avg) {
+		write_json_key(handler, "avg");
+		handler.Double(obj->get<statistics::tag::avg>());
+	}
+	if (tags & statistics::tag::moving_count) {
+		write_json_key(handler, "moving-count");
+		handler.Double(obj->get<statistics::tag::moving_count>());
+	}
+	if (tags & statistics::tag::moving_sum) {
+		write_json_key(handler, "moving-sum");
+		handler.Double(obj->get<statistics::tag::moving_sum>());
+	}
+	if (tags & statistics::tag::moving_avg) {
+		write_json_key(handler, "moving-avg");
+		handler.Double(obj->get<statistics::tag::moving_avg>());
+	}
+	if (tags & statistics::tag::histogram) {
+		const auto& histogram = obj->get<statistics::tag::histogram>();
+		write_json_key(handler, "histogram");
+		handler.StartArray();
+		for (auto bin = histogram.begin(); bin != histogram.end(); ++bin) {
+			handler.StartArray();
+			handler.Double(std::get<statistics::BIN_CENTER>(*bin));
+			handler.Double(std::get<statistics::BIN_COUNT>(*bin));
+			handler.EndArray(2);
+		}
+		handler.EndArray(histogram.size());
+	}
+	if (tags & statistics::tag::quantile) {
+		auto quantile = obj->get<statistics::tag::quantile>();
+		write_json_key(handler, "p25");
+		handler.Double(quantile.at(0.25));
+		write_json_key(handler, "p50");
+		handler.Double(quantile.at(0.50));
+		write_json_key(handler, "p75");
+		handler.Double(quantile.at(0.75));
+		write_json_key(handler, "p90");
+		handler.Double(quantile.at(0.90));
+		write_json_key(handler, "p95");
+		handler.Double(quantile.at(0.95));
+	}
+	if (tags & statistics::tag::timestamp) {
+		write_json_key(handler, "timestamp");
+		write_to_json_handler(obj->get<statistics::tag::timestamp>(), handler);
+	}
+	if (tags & statistics::tag::rate) {
+		write_json_key(handler, "rate");
+		handler.Double(obj->get<statistics::tag::rate>());
+	}
+	if (tags & statistics::tag::entropy) {
+		write_json_key(handler, "entropy");
+		handler.Double(obj->get<statistics::tag::entropy>());
+	}
+}
+
 template<typename StringBuffer, typename Allocator>
 inline void write_to_json_buffer(const statistics* const obj, StringBuffer* buffer, Allocator& allocator) {
 	rapidjson::Value json_value;
@@ -35,6 +35,13 @@ inline void write_to_json_value(const chrono::time_point& timestamp, rapidjson::
 	json_value->SetUint64(chrono::duration::convert_to(chrono::time_unit::MSEC, system_timestamp.time_since_epoch()).count());
 }
 
+template <typename Handler>
+inline void write_to_json_handler(const chrono::time_point& timestamp, Handler& handler) {
+	chrono::time_point system_timestamp = chrono::time_point::convert_to(chrono::clock_type::SYSTEM, timestamp);
+
+	handler.Uint64(chrono::duration::convert_to(chrono::time_unit::MSEC, system_timestamp.time_since_epoch()).count());
+}
+
 template<typename StringBuffer, typename Allocator>
 inline void write_to_json_buffer(const chrono::time_point& timestamp, StringBuffer* buffer, Allocator& allocator) {
 	rapidjson::Value json_value;
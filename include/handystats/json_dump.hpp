@@ -19,7 +19,12 @@
 #define HANDYSTATS_JSON_DUMP_HPP_
 
 #include <string>
+#include <memory>
 
+#include <handystats/rapidjson/writer.h>
+#include <handystats/rapidjson/prettywriter.h>
+
+#include <handystats/json/handler.hpp>
 #include <handystats/json/gauge_json_writer.hpp>
 #include <handystats/json/counter_json_writer.hpp>
 #include <handystats/json/timer_json_writer.hpp>
@@ -58,10 +63,112 @@ void fill(
 	}
 }
 
-std::string to_string(const std::map<std::string, handystats::metrics::metric_variant>&);
+/*
+ * Selects statistics tags to be serialized for metric by its name.
+ * Default filter passes all tags.
+ */
+struct all_tags_filter {
+	statistics::tag::type operator() (const std::string&) const {
+		return ~statistics::tag::empty;
+	}
+};
+
+/*
+ * Streaming (SAX) serialization of metrics dump.
+ * No intermediate DOM is built, events are passed directly to the handler
+ * (rapidjson::Writer-like object) in the same order as fill() would produce.
+ * Statistics filtered out by tags_filter are neither traversed nor written.
+ */
+template <typename Handler, typename TagsFilter>
+void write_to_json_handler(
+		const std::map<std::string, handystats::metrics::metric_variant>& metrics_map,
+		Handler& handler,
+		const TagsFilter& tags_filter
+	)
+{
+	handler.StartObject();
+
+	for (auto metric_iter = metrics_map.cbegin(); metric_iter != metrics_map.cend(); ++metric_iter) {
+		handler.String(metric_iter->first.c_str(), metric_iter->first.size());
+
+		switch (metric_iter->second.which()) {
+			case metrics::metric_index::GAUGE:
+				json::write_to_json_handler(&boost::get<metrics::gauge>(metric_iter->second), handler, tags_filter(metric_iter->first));
+				break;
+			case metrics::metric_index::COUNTER:
+				json::write_to_json_handler(&boost::get<metrics::counter>(metric_iter->second), handler, tags_filter(metric_iter->first));
+				break;
+			case metrics::metric_index::TIMER:
+				json::write_to_json_handler(&boost::get<metrics::timer>(metric_iter->second), handler, tags_filter(metric_iter->first));
+				break;
+			case metrics::metric_index::ATTRIBUTE:
+				json::write_to_json_handler(&boost::get<metrics::attribute>(metric_iter->second), handler);
+				break;
+		}
+	}
+
+	handler.EndObject(metrics_map.size());
+}
+
+template <typename Handler>
+void write_to_json_handler(
+		const std::map<std::string, handystats::metrics::metric_variant>& metrics_map,
+		Handler& handler
+	)
+{
+	write_to_json_handler(metrics_map, handler, all_tags_filter());
+}
+
+/*
+ * Serializes metrics dump into output stream.
+ * OutputStream should satisfy rapidjson stream concept (Put(Ch) and Flush()).
+ */
+template <typename OutputStream, typename TagsFilter>
+void write_to_stream(
+		const std::map<std::string, handystats::metrics::metric_variant>& metrics_map,
+		OutputStream& stream,
+		const bool& pretty,
+		const TagsFilter& tags_filter
+	)
+{
+	if (pretty) {
+		rapidjson::PrettyWriter<OutputStream> writer(stream);
+		write_to_json_handler(metrics_map, writer, tags_filter);
+	}
+	else {
+		rapidjson::Writer<OutputStream> writer(stream);
+		write_to_json_handler(metrics_map, writer, tags_filter);
+	}
+}
+
+template <typename OutputStream>
+void write_to_stream(
+		const std::map<std::string, handystats::metrics::metric_variant>& metrics_map,
+		OutputStream& stream,
+		const bool& pretty = true
+	)
+{
+	write_to_stream(metrics_map, stream, pretty, all_tags_filter());
+}
+
+// Following functions write all enabled statistics, "dump-filter" configuration option applies to HANDY_JSON_DUMP only
+std::string to_string(const std::map<std::string, handystats::metrics::metric_variant>&, const bool& pretty = true);
+
+// Appends serialized dump to the buffer, buffer's capacity is reused between calls
+void write_to_string(const std::map<std::string, handystats::metrics::metric_variant>&, std::string& buffer, const bool& pretty = true);
+
+// Writes serialized dump to file descriptor through fixed-size buffer, returns false on write error
+bool write_to_fd(const std::map<std::string, handystats::metrics::metric_variant>&, const int& fd, const bool& pretty = true);
 
 }} // namespace handystats::json
 
 std::string HANDY_JSON_DUMP();
 
+/*
+ * Shared immutable JSON dump rendered once per dump interval.
+ * Dump is rendered on dump update if "json" is listed in "dump-formats" configuration option,
+ * otherwise it is rendered on first call and shared by later calls until next dump.
+ */
+std::shared_ptr<const std::string> HANDY_JSON_DUMP_SHARED();
+
 #endif // HANDYSTATS_JSON_DUMP_HPP_
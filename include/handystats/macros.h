@@ -29,6 +29,11 @@
 #include <boost/preprocessor/facilities/empty.hpp>
 #include <boost/preprocessor/comma_if.hpp>
 
+#ifdef __cplusplus
+	#include <cstddef>
+	#include <type_traits>
+#endif
+
 /*
  * HANDY_PP_VARIADIC_SIZE(...)
  */
@@ -104,9 +109,90 @@
 	snprintf(HANDY_PP_METRIC_NAME_BUFFER_VAR, 255, HANDY_PP_METRIC_NAME_PRINT_ARGS(__VA_ARGS__)); \
 
 /*
- * HANDY_PP_MEASURING_POINT_WRAPPER
+ * HANDY_PP_METRIC_NAME_FORMAT(...)
+ * Metric name or printf-like format of metric name
  */
-#define HANDY_PP_MEASURING_POINT_WRAPPER(measuring_point_func, ...) \
+#define HANDY_PP_METRIC_NAME_FORMAT(...) \
+	BOOST_PP_EXPAND( HANDY_PP_TUPLE_REM() \
+		BOOST_PP_IF( \
+			HANDY_PP_IS_TUPLE(HANDY_PP_TUPLE_FIRST_ELEM((__VA_ARGS__))), \
+			( HANDY_PP_TUPLE_FIRST_ELEM((HANDY_PP_METRIC_NAME_PRINT_ARGS(__VA_ARGS__))) ), \
+			( HANDY_PP_TUPLE_FIRST_ELEM((__VA_ARGS__)) ) \
+		) \
+	)
+
+/*
+ * Compile-time metric name filtering (C++ only).
+ *
+ * HANDYSTATS_DISABLE_PREFIX -- string literal, measuring points with metric names
+ * (or name formats) starting with this prefix are compiled out.
+ * Per-category prefixes (HANDYSTATS_DISABLE_COUNTER_PREFIX, HANDYSTATS_DISABLE_GAUGE_PREFIX,
+ * HANDYSTATS_DISABLE_TIMER_PREFIX, HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX) override common one.
+ * Empty prefix disables nothing.
+ *
+ * Only names given as string literals are filtered, other names are never evaluated by the filter.
+ */
+#ifdef __cplusplus
+
+	#ifndef HANDYSTATS_DISABLE_PREFIX
+		#define HANDYSTATS_DISABLE_PREFIX ""
+	#endif
+
+	namespace handystats { namespace measuring_points {
+
+	template <typename Name>
+	struct is_metric_name_literal : std::false_type {};
+
+	template <size_t N>
+	struct is_metric_name_literal<const char (&)[N]> : std::true_type {};
+
+	constexpr bool metric_name_starts_with(const char* name, const char* prefix) {
+		return *prefix == '\0' || (*name == *prefix && metric_name_starts_with(name + 1, prefix + 1));
+	}
+
+	template <typename Name>
+	constexpr bool metric_name_starts_with(const Name&, const char*) {
+		return false;
+	}
+
+	constexpr bool metric_name_compiled_out(const char* name, const char* disabled_prefix) {
+		return *disabled_prefix != '\0' && metric_name_starts_with(name, disabled_prefix);
+	}
+
+	template <typename Name>
+	constexpr bool metric_name_compiled_out(const Name&, const char*) {
+		return false;
+	}
+
+	}} // namespace handystats::measuring_points
+
+	// forced compile-time evaluation, name is never evaluated at runtime
+	#define HANDY_PP_METRIC_NAME_COMPILED_OUT_I(disabled_prefix, name) \
+		std::integral_constant<bool, \
+			handystats::measuring_points::is_metric_name_literal<decltype((name))>::value && \
+			handystats::measuring_points::metric_name_compiled_out(name, disabled_prefix) \
+		>::value
+
+	#define HANDY_PP_METRIC_NAME_COMPILED_OUT(disabled_prefix, ...) \
+		HANDY_PP_METRIC_NAME_COMPILED_OUT_I(disabled_prefix, HANDY_PP_METRIC_NAME_FORMAT(__VA_ARGS__))
+
+#endif
+
+/*
+ * HANDY_PP_MEASURING_POINT_ENABLED()
+ * C++ measuring points check runtime enabled flag inline (see handystats/core.hpp),
+ * so neither name formatting nor arguments are evaluated while handystats is disabled.
+ */
+#ifdef __cplusplus
+	#define HANDY_PP_MEASURING_POINT_ENABLED() handystats::is_enabled()
+#else
+	#define HANDY_PP_MEASURING_POINT_ENABLED() 1
+#endif
+
+/*
+ * HANDY_PP_MEASURING_POINT_CALL
+ */
+#define HANDY_PP_MEASURING_POINT_CALL(measuring_point_func, ...) \
 	BOOST_PP_EXPAND ( HANDY_PP_TUPLE_REM() \
 		BOOST_PP_IF( \
 			HANDY_PP_IS_TUPLE(HANDY_PP_TUPLE_FIRST_ELEM((__VA_ARGS__))), \
@@ -130,4 +216,46 @@
 		) \
 	)
 
+/*
+ * HANDY_PP_MEASURING_POINT_GUARD(condition, measuring_point_func, ...)
+ * Measuring point is called only if condition holds.
+ * Measuring point with plain metric name is an expression, so it could be used
+ * in expression context (e.g. `cond ? HANDY_COUNTER_INCREMENT("name") : void()`).
+ * printf-like format needs name buffer and is a statement.
+ */
+#define HANDY_PP_MEASURING_POINT_GUARD(condition, measuring_point_func, ...) \
+	BOOST_PP_EXPAND ( HANDY_PP_TUPLE_REM() \
+		BOOST_PP_IF( \
+			HANDY_PP_IS_TUPLE(HANDY_PP_TUPLE_FIRST_ELEM((__VA_ARGS__))), \
+			/* if printf-like format */ \
+			( \
+				do { \
+					if (condition) { \
+						HANDY_PP_MEASURING_POINT_CALL(measuring_point_func, __VA_ARGS__); \
+					} \
+				} while (0) \
+			), \
+			/* else expression */ \
+			( \
+				((condition) ? (void)(HANDY_PP_MEASURING_POINT_CALL(measuring_point_func, __VA_ARGS__)) : (void)0) \
+			) \
+		) \
+	)
+
+/*
+ * HANDY_PP_MEASURING_POINT_WRAPPER
+ */
+#define HANDY_PP_MEASURING_POINT_WRAPPER(measuring_point_func, ...) \
+	HANDY_PP_MEASURING_POINT_GUARD(HANDY_PP_MEASURING_POINT_ENABLED(), measuring_point_func, __VA_ARGS__)
+
+/*
+ * HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER (C++ only)
+ * Measuring point is compiled out if metric name literal starts with disabled_prefix.
+ */
+#define HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(disabled_prefix, measuring_point_func, ...) \
+	HANDY_PP_MEASURING_POINT_GUARD( \
+		!HANDY_PP_METRIC_NAME_COMPILED_OUT(disabled_prefix, __VA_ARGS__) && HANDY_PP_MEASURING_POINT_ENABLED(), \
+		measuring_point_func, __VA_ARGS__ \
+	)
+
 #endif // HANDYSTATS_MACROS_H_
@@ -18,6 +18,22 @@
 #ifndef HANDYSTATS_MEASURING_POINTS_HPP_
 #define HANDYSTATS_MEASURING_POINTS_HPP_
 
+/*
+ * Compile-time controls for HANDY_* measuring points (should be defined before inclusion):
+ *
+ * HANDYSTATS_DISABLE -- all measuring points are compiled out
+ *
+ * HANDYSTATS_DISABLE_COUNTER, HANDYSTATS_DISABLE_GAUGE,
+ * HANDYSTATS_DISABLE_TIMER, HANDYSTATS_DISABLE_ATTRIBUTE -- measuring points
+ * (including scope macros) of corresponding metric type are compiled out
+ *
+ * HANDYSTATS_DISABLE_PREFIX, HANDYSTATS_DISABLE_<TYPE>_PREFIX -- string literal,
+ * measuring points with literal metric names starting with the prefix are compiled out
+ * (e.g. -DHANDYSTATS_DISABLE_TIMER_PREFIX='"debug."'), see handystats/macros.h
+ *
+ * Compiled out measuring points evaluate neither their arguments nor metric name format.
+ */
+
 #include <handystats/measuring_points/gauge.hpp>
 #include <handystats/measuring_points/counter.hpp>
 #include <handystats/measuring_points/timer.hpp>
@@ -28,4 +44,6 @@
 #include <handystats/measuring_points/timer_proxy.hpp>
 #include <handystats/measuring_points/attribute_proxy.hpp>
 
+#include <handystats/measuring_points/batch.hpp>
+
 #endif // HANDYSTATS_MEASURING_POINTS_HPP_
@@ -67,7 +67,7 @@ void handystats_attribute_set_string(
 
 
 #ifndef __cplusplus
-	#ifndef HANDYSTATS_DISABLE
+	#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_ATTRIBUTE)
 
 		#define HANDY_ATTRIBUTE_SET_BOOL(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats_attribute_set_bool, __VA_ARGS__)
 
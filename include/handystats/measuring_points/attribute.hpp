@@ -23,6 +23,7 @@
 #include <string>
 
 #include <handystats/metrics/attribute.hpp>
+#include <handystats/core.hpp>
 #include <handystats/macros.h>
 
 
@@ -94,23 +95,27 @@ void attribute_set<std::string>(
 }} // namespace handystats::measuring_points
 
 
-#ifndef HANDYSTATS_DISABLE
+#ifndef HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX
+	#define HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX HANDYSTATS_DISABLE_PREFIX
+#endif
+
+#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_ATTRIBUTE)
 
-	#define HANDY_ATTRIBUTE_SET(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::attribute_set, __VA_ARGS__)
+	#define HANDY_ATTRIBUTE_SET(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX, handystats::measuring_points::attribute_set, __VA_ARGS__)
 
-	#define HANDY_ATTRIBUTE_SET_BOOL(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::attribute_set<bool>, __VA_ARGS__)
+	#define HANDY_ATTRIBUTE_SET_BOOL(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX, handystats::measuring_points::attribute_set<bool>, __VA_ARGS__)
 
-	#define HANDY_ATTRIBUTE_SET_INT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::attribute_set<int>, __VA_ARGS__)
+	#define HANDY_ATTRIBUTE_SET_INT(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX, handystats::measuring_points::attribute_set<int>, __VA_ARGS__)
 
-	#define HANDY_ATTRIBUTE_SET_UINT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::attribute_set<unsigned>, __VA_ARGS__)
+	#define HANDY_ATTRIBUTE_SET_UINT(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX, handystats::measuring_points::attribute_set<unsigned>, __VA_ARGS__)
 
-	#define HANDY_ATTRIBUTE_SET_INT64(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::attribute_set<int64_t>, __VA_ARGS__)
+	#define HANDY_ATTRIBUTE_SET_INT64(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX, handystats::measuring_points::attribute_set<int64_t>, __VA_ARGS__)
 
-	#define HANDY_ATTRIBUTE_SET_UINT64(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::attribute_set<uint64_t>, __VA_ARGS__)
+	#define HANDY_ATTRIBUTE_SET_UINT64(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX, handystats::measuring_points::attribute_set<uint64_t>, __VA_ARGS__)
 
-	#define HANDY_ATTRIBUTE_SET_DOUBLE(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::attribute_set<double>, __VA_ARGS__)
+	#define HANDY_ATTRIBUTE_SET_DOUBLE(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX, handystats::measuring_points::attribute_set<double>, __VA_ARGS__)
 
-	#define HANDY_ATTRIBUTE_SET_STRING(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::attribute_set<std::string>, __VA_ARGS__)
+	#define HANDY_ATTRIBUTE_SET_STRING(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_ATTRIBUTE_PREFIX, handystats::measuring_points::attribute_set<std::string>, __VA_ARGS__)
 
 #else
 
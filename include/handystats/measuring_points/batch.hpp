@@ -0,0 +1,223 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_MEASURING_POINTS_BATCH_HPP_
+#define HANDYSTATS_MEASURING_POINTS_BATCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+
+#include <handystats/chrono.hpp>
+#include <handystats/metrics/counter.hpp>
+#include <handystats/metrics/gauge.hpp>
+#include <handystats/metrics/timer.hpp>
+#include <handystats/metrics/attribute.hpp>
+#include <handystats/measuring_points/clock.hpp>
+
+namespace handystats { namespace events {
+
+struct event_message;
+
+}} // namespace handystats::events
+
+namespace handystats { namespace measuring_points {
+
+/*
+ * Batch of measurements.
+ *
+ * Measurements are collected locally and passed to handystats core
+ * as single compound event on submit() (or on batch destruction),
+ * which costs only one message queue push for the whole batch.
+ *
+ * Batch object is not thread-safe.
+ */
+class batch {
+public:
+	batch();
+	~batch();
+
+	/*
+	 * Counter measurements
+	 */
+	void counter_init(
+			std::string&& counter_name,
+			const metrics::counter::value_type& init_value = metrics::counter::value_type(),
+			const metrics::counter::time_point& timestamp = counter_clock::now()
+		);
+
+	void counter_increment(
+			std::string&& counter_name,
+			const metrics::counter::value_type& value = 1,
+			const metrics::counter::time_point& timestamp = counter_clock::now()
+		);
+
+	void counter_decrement(
+			std::string&& counter_name,
+			const metrics::counter::value_type& value = 1,
+			const metrics::counter::time_point& timestamp = counter_clock::now()
+		);
+
+	void counter_change(
+			std::string&& counter_name,
+			const metrics::counter::value_type& value,
+			const metrics::counter::time_point& timestamp = counter_clock::now()
+		);
+
+	/*
+	 * Gauge measurements
+	 */
+	void gauge_init(
+			std::string&& gauge_name,
+			const metrics::gauge::value_type& init_value = metrics::gauge::value_type(),
+			const metrics::gauge::time_point& timestamp = gauge_clock::now()
+		);
+
+	void gauge_set(
+			std::string&& gauge_name,
+			const metrics::gauge::value_type& value,
+			const metrics::gauge::time_point& timestamp = gauge_clock::now()
+		);
+
+	/*
+	 * Timer measurements
+	 */
+	void timer_init(
+			std::string&& timer_name,
+			const metrics::timer::instance_id_type& instance_id = metrics::timer::DEFAULT_INSTANCE_ID,
+			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
+		);
+
+	void timer_start(
+			std::string&& timer_name,
+			const metrics::timer::instance_id_type& instance_id = metrics::timer::DEFAULT_INSTANCE_ID,
+			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
+		);
+
+	void timer_stop(
+			std::string&& timer_name,
+			const metrics::timer::instance_id_type& instance_id = metrics::timer::DEFAULT_INSTANCE_ID,
+			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
+		);
+
+	void timer_discard(
+			std::string&& timer_name,
+			const metrics::timer::instance_id_type& instance_id = metrics::timer::DEFAULT_INSTANCE_ID,
+			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
+		);
+
+	void timer_heartbeat(
+			std::string&& timer_name,
+			const metrics::timer::instance_id_type& instance_id = metrics::timer::DEFAULT_INSTANCE_ID,
+			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
+		);
+
+	void timer_set(
+			std::string&& timer_name,
+			const metrics::timer::value_type& measurement,
+			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
+		);
+
+	/*
+	 * Attribute measurements
+	 */
+	void attribute_set(
+			std::string&& attribute_name,
+			const metrics::attribute::value_type& value,
+			const metrics::attribute::time_point& timestamp = metrics::attribute::clock::now()
+		);
+
+	// support for primitive types (as in metrics::attribute)
+	void attribute_set(
+			std::string&& attribute_name,
+			const bool& b,
+			const metrics::attribute::time_point& timestamp = metrics::attribute::clock::now()
+		);
+
+	void attribute_set(
+			std::string&& attribute_name,
+			const int& i,
+			const metrics::attribute::time_point& timestamp = metrics::attribute::clock::now()
+		);
+
+	void attribute_set(
+			std::string&& attribute_name,
+			const unsigned& u,
+			const metrics::attribute::time_point& timestamp = metrics::attribute::clock::now()
+		);
+
+	void attribute_set(
+			std::string&& attribute_name,
+			const int64_t& i64,
+			const metrics::attribute::time_point& timestamp = metrics::attribute::clock::now()
+		);
+
+	void attribute_set(
+			std::string&& attribute_name,
+			const uint64_t& u64,
+			const metrics::attribute::time_point& timestamp = metrics::attribute::clock::now()
+		);
+
+	void attribute_set(
+			std::string&& attribute_name,
+			const double& d,
+			const metrics::attribute::time_point& timestamp = metrics::attribute::clock::now()
+		);
+
+	// support for strings
+	void attribute_set(
+			std::string&& attribute_name,
+			const char* s,
+			const metrics::attribute::time_point& timestamp = metrics::attribute::clock::now()
+		);
+
+	void attribute_set(
+			std::string&& attribute_name,
+			const std::string& s,
+			const metrics::attribute::time_point& timestamp = metrics::attribute::clock::now()
+		);
+
+	/*
+	 * Pass collected measurements to handystats core.
+	 * Batch is empty afterwards and could be reused.
+	 */
+	void submit();
+
+	/*
+	 * Drop collected measurements.
+	 */
+	void discard();
+
+	size_t size() const;
+	bool empty() const;
+
+private:
+	batch(const batch&);
+	batch& operator= (const batch&);
+
+	void append(events::event_message* message);
+
+	events::event_message* m_first;
+	events::event_message* m_last;
+	size_t m_size;
+	chrono::time_point m_timestamp;
+};
+
+}} // namespace handystats::measuring_points
+
+#endif // HANDYSTATS_MEASURING_POINTS_BATCH_HPP_
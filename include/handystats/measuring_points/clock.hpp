@@ -0,0 +1,67 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+#ifndef HANDYSTATS_MEASURING_POINTS_CLOCK_HPP_
+#define HANDYSTATS_MEASURING_POINTS_CLOCK_HPP_
+
+#include <handystats/atomic.hpp>
+#include <handystats/chrono.hpp>
+#include <handystats/metrics/counter.hpp>
+#include <handystats/metrics/gauge.hpp>
+
+namespace handystats { namespace measuring_points {
+
+/*
+ * Coarse timestamp flags.
+ * Published by handystats core from "timestamp" option of metric type configuration
+ * on initialization and cleared on finalization, but read by each measuring point,
+ * so each occupies whole cache line and is read with relaxed ordering.
+ */
+struct coarse_timestamp_flag_type : std::atomic<bool> {
+	coarse_timestamp_flag_type(const bool& value)
+		: std::atomic<bool>(value)
+	{}
+} __attribute__((aligned(64)));
+
+extern coarse_timestamp_flag_type counter_coarse_timestamp;
+extern coarse_timestamp_flag_type gauge_coarse_timestamp;
+
+/*
+ * Clocks for default timestamps of measuring points.
+ * Depending on "timestamp" option of metric type configuration
+ * chrono::tsc_clock ("precise", default) or chrono::coarse_clock ("coarse") is used.
+ */
+struct counter_clock {
+	static handystats::metrics::counter::time_point now() {
+		if (counter_coarse_timestamp.load(std::memory_order_relaxed)) {
+			return chrono::coarse_clock::now();
+		}
+		return chrono::tsc_clock::now();
+	}
+};
+
+struct gauge_clock {
+	static handystats::metrics::gauge::time_point now() {
+		if (gauge_coarse_timestamp.load(std::memory_order_relaxed)) {
+			return chrono::coarse_clock::now();
+		}
+		return chrono::tsc_clock::now();
+	}
+};
+
+}} // namespace handystats::measuring_points
+
+#endif // HANDYSTATS_MEASURING_POINTS_CLOCK_HPP_
@@ -51,7 +51,7 @@ void handystats_counter_change(
 
 
 #ifndef __cplusplus
-	#ifndef HANDYSTATS_DISABLE
+	#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_COUNTER)
 
 		#define HANDY_COUNTER_INIT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats_counter_init, __VA_ARGS__)
 
@@ -84,7 +84,7 @@ void handystats_counter_change(
 
 	#define C_UNIQUE_SCOPED_COUNTER_NAME BOOST_PP_LIST_CAT((C_HANDY_SCOPED_COUNTER_VAR_, (__LINE__, BOOST_PP_NIL)))
 
-	#ifndef HANDYSTATS_DISABLE
+	#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_COUNTER)
 
 		#define HANDY_COUNTER_SCOPE(counter_name, delta_value) \
 			BOOST_PP_EXPAND( HANDY_PP_TUPLE_REM() \
@@ -24,6 +24,8 @@
 #include <boost/preprocessor/list/cat.hpp>
 
 #include <handystats/metrics/counter.hpp>
+#include <handystats/measuring_points/clock.hpp>
+#include <handystats/core.hpp>
 #include <handystats/macros.h>
 
 
@@ -32,25 +34,25 @@ namespace handystats { namespace measuring_points {
 void counter_init(
 		std::string&& counter_name,
 		const handystats::metrics::counter::value_type& init_value = handystats::metrics::counter::value_type(),
-		const handystats::metrics::counter::time_point& timestamp = handystats::metrics::counter::clock::now()
+		const handystats::metrics::counter::time_point& timestamp = handystats::measuring_points::counter_clock::now()
 		);
 
 void counter_increment(
 		std::string&& counter_name,
 		const handystats::metrics::counter::value_type& value = 1,
-		const handystats::metrics::counter::time_point& timestamp = handystats::metrics::counter::clock::now()
+		const handystats::metrics::counter::time_point& timestamp = handystats::measuring_points::counter_clock::now()
 		);
 
 void counter_decrement(
 		std::string&& counter_name,
 		const handystats::metrics::counter::value_type& value = 1,
-		const handystats::metrics::counter::time_point& timestamp = handystats::metrics::counter::clock::now()
+		const handystats::metrics::counter::time_point& timestamp = handystats::measuring_points::counter_clock::now()
 		);
 
 void counter_change(
 		std::string&& counter_name,
 		const handystats::metrics::counter::value_type& value,
-		const handystats::metrics::counter::time_point& timestamp = handystats::metrics::counter::clock::now()
+		const handystats::metrics::counter::time_point& timestamp = handystats::measuring_points::counter_clock::now()
 		);
 
 /*
@@ -76,15 +78,19 @@ struct scoped_counter_helper {
 }} // namespace handystats::measuring_points
 
 
-#ifndef HANDYSTATS_DISABLE
+#ifndef HANDYSTATS_DISABLE_COUNTER_PREFIX
+	#define HANDYSTATS_DISABLE_COUNTER_PREFIX HANDYSTATS_DISABLE_PREFIX
+#endif
+
+#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_COUNTER)
 
-	#define HANDY_COUNTER_INIT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::counter_init, __VA_ARGS__)
+	#define HANDY_COUNTER_INIT(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_COUNTER_PREFIX, handystats::measuring_points::counter_init, __VA_ARGS__)
 
-	#define HANDY_COUNTER_INCREMENT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::counter_increment, __VA_ARGS__)
+	#define HANDY_COUNTER_INCREMENT(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_COUNTER_PREFIX, handystats::measuring_points::counter_increment, __VA_ARGS__)
 
-	#define HANDY_COUNTER_DECREMENT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::counter_decrement, __VA_ARGS__)
+	#define HANDY_COUNTER_DECREMENT(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_COUNTER_PREFIX, handystats::measuring_points::counter_decrement, __VA_ARGS__)
 
-	#define HANDY_COUNTER_CHANGE(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::counter_change, __VA_ARGS__)
+	#define HANDY_COUNTER_CHANGE(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_COUNTER_PREFIX, handystats::measuring_points::counter_change, __VA_ARGS__)
 
 #else
 
@@ -123,7 +129,7 @@ struct scoped_counter_helper {
 /*
  * HANDY_COUNTER_SCOPE event constructs scoped_counter_helper named variable.
  */
-#ifndef HANDYSTATS_DISABLE
+#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_COUNTER)
 
 	#define HANDY_COUNTER_SCOPE(...) HANDY_PP_OVERLOAD(HANDY_COUNTER_SCOPE_,__VA_ARGS__)(__VA_ARGS__)
 
@@ -44,7 +44,7 @@ public:
 	 */
 	counter_proxy(const std::string& name,
 			const metrics::counter::value_type& init_value,
-			const metrics::counter::time_point& timestamp = metrics::counter::clock::now()
+			const metrics::counter::time_point& timestamp = counter_clock::now()
 		)
 		: name(name)
 	{
@@ -53,7 +53,7 @@ public:
 
 	counter_proxy(const char* name,
 			const metrics::counter::value_type& init_value,
-			const metrics::counter::time_point& timestamp = metrics::counter::clock::now()
+			const metrics::counter::time_point& timestamp = counter_clock::now()
 		)
 		: name(name)
 	{
@@ -65,7 +65,7 @@ public:
 	 */
 	void init(
 			const metrics::counter::value_type& init_value = metrics::counter::value_type(),
-			const metrics::counter::time_point& timestamp = metrics::counter::clock::now()
+			const metrics::counter::time_point& timestamp = counter_clock::now()
 		)
 	{
 		HANDY_COUNTER_INIT(name.substr(), init_value, timestamp);
@@ -76,7 +76,7 @@ public:
 	 */
 	void increment(
 			const metrics::counter::value_type& value = 1,
-			const metrics::counter::time_point& timestamp = metrics::counter::clock::now()
+			const metrics::counter::time_point& timestamp = counter_clock::now()
 		)
 	{
 		HANDY_COUNTER_INCREMENT(name.substr(), value, timestamp);
@@ -87,7 +87,7 @@ public:
 	 */
 	void decrement(
 			const metrics::counter::value_type& value = 1,
-			const metrics::counter::time_point& timestamp = metrics::counter::clock::now()
+			const metrics::counter::time_point& timestamp = counter_clock::now()
 		)
 	{
 		HANDY_COUNTER_DECREMENT(name.substr(), value, timestamp);
@@ -98,7 +98,7 @@ public:
 	 */
 	void change(
 			const metrics::counter::value_type& value,
-			const metrics::counter::time_point& timestamp = metrics::counter::clock::now()
+			const metrics::counter::time_point& timestamp = counter_clock::now()
 		)
 	{
 		HANDY_COUNTER_CHANGE(name.substr(), value, timestamp);
@@ -35,7 +35,7 @@ void handystats_gauge_set(
 
 
 #ifndef __cplusplus
-	#ifndef HANDYSTATS_DISABLE
+	#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_GAUGE)
 
 		#define HANDY_GAUGE_INIT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats_gauge_init, __VA_ARGS__)
 
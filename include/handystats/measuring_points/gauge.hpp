@@ -20,8 +20,10 @@
 
 #include <string>
 
+#include <handystats/core.hpp>
 #include <handystats/macros.h>
 #include <handystats/metrics/gauge.hpp>
+#include <handystats/measuring_points/clock.hpp>
 
 
 namespace handystats { namespace measuring_points {
@@ -29,23 +31,27 @@ namespace handystats { namespace measuring_points {
 void gauge_init(
 		std::string&& gauge_name,
 		const handystats::metrics::gauge::value_type& init_value,
-		const handystats::metrics::gauge::time_point& timestamp = handystats::metrics::gauge::clock::now()
+		const handystats::metrics::gauge::time_point& timestamp = handystats::measuring_points::gauge_clock::now()
 	);
 
 void gauge_set(
 		std::string&& gauge_name,
 		const handystats::metrics::gauge::value_type& value,
-		const handystats::metrics::gauge::time_point& timestamp = handystats::metrics::gauge::clock::now()
+		const handystats::metrics::gauge::time_point& timestamp = handystats::measuring_points::gauge_clock::now()
 	);
 
 }} // namespace handystats::measuring_points
 
 
-#ifndef HANDYSTATS_DISABLE
+#ifndef HANDYSTATS_DISABLE_GAUGE_PREFIX
+	#define HANDYSTATS_DISABLE_GAUGE_PREFIX HANDYSTATS_DISABLE_PREFIX
+#endif
+
+#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_GAUGE)
 
-	#define HANDY_GAUGE_INIT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::gauge_init, __VA_ARGS__)
+	#define HANDY_GAUGE_INIT(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_GAUGE_PREFIX, handystats::measuring_points::gauge_init, __VA_ARGS__)
 
-	#define HANDY_GAUGE_SET(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::gauge_set, __VA_ARGS__)
+	#define HANDY_GAUGE_SET(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_GAUGE_PREFIX, handystats::measuring_points::gauge_set, __VA_ARGS__)
 
 #else
 
@@ -63,7 +63,7 @@ void handystats_timer_set(
 	);
 
 #ifndef __cplusplus
-	#ifndef HANDYSTATS_DISABLE
+	#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_TIMER)
 
 		#define HANDY_TIMER_INIT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats_timer_init, __VA_ARGS__)
 
@@ -105,7 +105,7 @@ void handystats_timer_set(
 
 	#define C_UNIQUE_SCOPED_TIMER_NAME BOOST_PP_LIST_CAT((C_HANDY_SCOPED_TIMER_VAR_, (__LINE__, BOOST_PP_NIL)))
 
-	#ifndef HANDYSTATS_DISABLE
+	#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_TIMER)
 
 		#define HANDY_TIMER_SCOPE(timer_name) \
 			BOOST_PP_EXPAND( HANDY_PP_TUPLE_REM() \
@@ -25,6 +25,7 @@
 #include <boost/preprocessor/list/cat.hpp>
 
 #include <handystats/metrics/timer.hpp>
+#include <handystats/core.hpp>
 #include <handystats/macros.h>
 
 
@@ -89,19 +90,23 @@ struct scoped_timer_helper {
 }} // namespace handystats::measuring_points
 
 
-#ifndef HANDYSTATS_DISABLE
+#ifndef HANDYSTATS_DISABLE_TIMER_PREFIX
+	#define HANDYSTATS_DISABLE_TIMER_PREFIX HANDYSTATS_DISABLE_PREFIX
+#endif
+
+#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_TIMER)
 
-	#define HANDY_TIMER_INIT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::timer_init, __VA_ARGS__)
+	#define HANDY_TIMER_INIT(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_TIMER_PREFIX, handystats::measuring_points::timer_init, __VA_ARGS__)
 
-	#define HANDY_TIMER_START(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::timer_start, __VA_ARGS__)
+	#define HANDY_TIMER_START(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_TIMER_PREFIX, handystats::measuring_points::timer_start, __VA_ARGS__)
 
-	#define HANDY_TIMER_STOP(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::timer_stop, __VA_ARGS__)
+	#define HANDY_TIMER_STOP(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_TIMER_PREFIX, handystats::measuring_points::timer_stop, __VA_ARGS__)
 
-	#define HANDY_TIMER_DISCARD(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::timer_discard, __VA_ARGS__)
+	#define HANDY_TIMER_DISCARD(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_TIMER_PREFIX, handystats::measuring_points::timer_discard, __VA_ARGS__)
 
-	#define HANDY_TIMER_HEARTBEAT(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::timer_heartbeat, __VA_ARGS__)
+	#define HANDY_TIMER_HEARTBEAT(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_TIMER_PREFIX, handystats::measuring_points::timer_heartbeat, __VA_ARGS__)
 
-	#define HANDY_TIMER_SET(...) HANDY_PP_MEASURING_POINT_WRAPPER(handystats::measuring_points::timer_set, __VA_ARGS__)
+	#define HANDY_TIMER_SET(...) HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER(HANDYSTATS_DISABLE_TIMER_PREFIX, handystats::measuring_points::timer_set, __VA_ARGS__)
 
 #else
 
@@ -128,7 +133,7 @@ struct scoped_timer_helper {
 /*
  * HANDY_TIMER_SCOPE event constructs scoped_timer_helper named variable.
  */
-#ifndef HANDYSTATS_DISABLE
+#if !defined(HANDYSTATS_DISABLE) && !defined(HANDYSTATS_DISABLE_TIMER)
 
 	#define HANDY_TIMER_SCOPE(timer_name) \
 		BOOST_PP_EXPAND( HANDY_PP_TUPLE_REM() \
@@ -28,21 +28,55 @@ namespace handystats { namespace measuring_points {
 
 class timer_proxy {
 public:
+	/*
+	 * Measurement modes
+	 *
+	 * EVENTS -- start and stop events are passed to handystats core,
+	 *           which pairs them by instance id.
+	 * LOCAL  -- start timestamp is kept in proxy and single set event is passed on stop.
+	 *           Only one measurement could be in progress at a time, instance ids and heartbeats are ignored,
+	 *           proxy object is not thread-safe.
+	 */
+	enum class measurement_mode {
+		EVENTS,
+		LOCAL
+	};
+
 	/*
 	 * Ctors without sending init event
 	 */
 	timer_proxy(const std::string& name,
-			const metrics::timer::instance_id_type& instance_id = metrics::timer::DEFAULT_INSTANCE_ID
+			const metrics::timer::instance_id_type& instance_id = metrics::timer::DEFAULT_INSTANCE_ID,
+			const measurement_mode& mode = measurement_mode::EVENTS
 		)
 		: name(name)
 		, instance_id(instance_id)
+		, mode(mode)
+		, started(false)
 	{}
 
 	timer_proxy(const char* name,
-			const metrics::timer::instance_id_type& instance_id = metrics::timer::DEFAULT_INSTANCE_ID
+			const metrics::timer::instance_id_type& instance_id = metrics::timer::DEFAULT_INSTANCE_ID,
+			const measurement_mode& mode = measurement_mode::EVENTS
 		)
 		: name(name)
 		, instance_id(instance_id)
+		, mode(mode)
+		, started(false)
+	{}
+
+	timer_proxy(const std::string& name, const measurement_mode& mode)
+		: name(name)
+		, instance_id(metrics::timer::DEFAULT_INSTANCE_ID)
+		, mode(mode)
+		, started(false)
+	{}
+
+	timer_proxy(const char* name, const measurement_mode& mode)
+		: name(name)
+		, instance_id(metrics::timer::DEFAULT_INSTANCE_ID)
+		, mode(mode)
+		, started(false)
 	{}
 
 	/*
@@ -64,6 +98,12 @@ public:
 			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
 		)
 	{
+		if (mode == measurement_mode::LOCAL) {
+			start_timestamp = timestamp;
+			started = true;
+			return;
+		}
+
 		HANDY_TIMER_START(name.substr(), choose_instance_id(instance_id), timestamp);
 	}
 
@@ -75,6 +115,14 @@ public:
 			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
 		)
 	{
+		if (mode == measurement_mode::LOCAL) {
+			if (started) {
+				started = false;
+				HANDY_TIMER_SET(name.substr(), timestamp - start_timestamp, timestamp);
+			}
+			return;
+		}
+
 		HANDY_TIMER_STOP(name.substr(), choose_instance_id(instance_id), timestamp);
 	}
 
@@ -86,6 +134,11 @@ public:
 			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
 		)
 	{
+		if (mode == measurement_mode::LOCAL) {
+			started = false;
+			return;
+		}
+
 		HANDY_TIMER_DISCARD(name.substr(), choose_instance_id(instance_id), timestamp);
 	}
 
@@ -97,6 +150,10 @@ public:
 			const metrics::timer::time_point& timestamp = metrics::timer::clock::now()
 		)
 	{
+		if (mode == measurement_mode::LOCAL) {
+			return;
+		}
+
 		HANDY_TIMER_HEARTBEAT(name.substr(), choose_instance_id(instance_id), timestamp);
 	}
 
@@ -114,6 +171,11 @@ public:
 private:
 	const std::string name;
 	const metrics::timer::instance_id_type instance_id;
+	const measurement_mode mode;
+
+	// local measurement state
+	metrics::timer::time_point start_timestamp;
+	bool started;
 
 	metrics::timer::instance_id_type choose_instance_id(const metrics::timer::instance_id_type& instance_id) {
 		if (this->instance_id != metrics::timer::DEFAULT_INSTANCE_ID) {
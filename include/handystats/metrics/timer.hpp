@@ -91,6 +91,9 @@ struct timer
 
 	void update_statistics(const time_point& timestamp = clock::now());
 
+	// number of started and not yet stopped (or expired) instances
+	size_t running_instances() const;
+
 	const statistics& values() const;
 
 private:
@@ -20,10 +20,41 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <map>
+#include <cstdint>
 
 #include <handystats/metrics.hpp>
 
+namespace handystats { namespace metrics_dump {
+
+/*
+ * Difference between metrics dump and dump of previous generation.
+ *
+ * Metric is considered changed if it has received any event since the previous generation.
+ * Internal handystats' metrics are always included.
+ */
+struct delta {
+	// generation of the dump delta is built from, should be passed as 'since' to the next request
+	uint64_t generation;
+
+	// true if 'since' generation is unknown (zero, too old or from previous initialization),
+	// changed contains all metrics of the dump then
+	bool full;
+
+	std::map<std::string, metrics::metric_variant> changed;
+	std::vector<std::string> removed;
+
+	delta()
+		: generation(0)
+		, full(true)
+		, changed()
+		, removed()
+	{}
+};
+
+}} // namespace handystats::metrics_dump
+
 const std::shared_ptr <
 	const std::map <
 		std::string, handystats::metrics::metric_variant
@@ -31,4 +62,6 @@ const std::shared_ptr <
 	>
 HANDY_METRICS_DUMP();
 
+handystats::metrics_dump::delta HANDY_METRICS_DUMP_DELTA(const uint64_t& since = 0);
+
 #endif // HANDYSTATS_METRICS_DUMP_HPP_
@@ -0,0 +1,65 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_PROMETHEUS_DUMP_HPP_
+#define HANDYSTATS_PROMETHEUS_DUMP_HPP_
+
+#include <string>
+#include <memory>
+#include <map>
+
+#include <handystats/metrics.hpp>
+#include <handystats/metrics_dump.hpp>
+
+/*
+ * Prometheus text exposition format (version 0.0.4).
+ *
+ * Metric names are sanitized to [a-zA-Z_:][a-zA-Z0-9_:]* ('.' and other symbols are replaced with '_').
+ * Metric whose exposed names collide with names of metric written before it (e.g. "a.b" and "a_b",
+ * or "x.count" and "x" timer's x_count) is skipped, so each family is exposed once.
+ *
+ * counter -> gauge (counters could be decremented)
+ * gauge -> gauge
+ * timer -> summary (quantiles p25 - p95, <name>_sum, <name>_count)
+ * histogram statistics -> histogram <name>_histogram with cumulative buckets
+ * attribute -> gauge (bool as 0/1), string attribute -> <name>_info{value="..."} 1
+ *
+ * Other enabled statistics are exposed as gauges <name>_<statistics tag> (e.g. <name>_moving_avg).
+ */
+
+namespace handystats { namespace prometheus {
+
+std::string to_string(const std::map<std::string, handystats::metrics::metric_variant>&);
+
+// Appends serialized dump to the buffer
+void write_to_string(const std::map<std::string, handystats::metrics::metric_variant>&, std::string& buffer);
+
+// Writes serialized dump to file descriptor through fixed-size buffer, returns false on write error
+bool write_to_fd(const std::map<std::string, handystats::metrics::metric_variant>&, const int& fd);
+
+}} // namespace handystats::prometheus
+
+std::string HANDY_PROMETHEUS_DUMP();
+
+/*
+ * Shared immutable Prometheus dump rendered once per dump interval.
+ * Dump is rendered on dump update if "prometheus" is listed in "dump-formats" configuration option,
+ * otherwise it is rendered on first call and shared by later calls until next dump.
+ */
+std::shared_ptr<const std::string> HANDY_PROMETHEUS_DUMP_SHARED();
+
+#endif // HANDYSTATS_PROMETHEUS_DUMP_HPP_
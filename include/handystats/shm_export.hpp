@@ -0,0 +1,92 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_SHM_EXPORT_HPP_
+#define HANDYSTATS_SHM_EXPORT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+/*
+ * Shared memory export of metrics dump.
+ *
+ * If "shm-export" is configured, each metrics dump is published into POSIX shared memory object
+ * in binary format (see handystats/binary_dump.hpp) on the processing thread.
+ * Collectors on the same host read dumps with shm_export::reader without any calls into the process.
+ *
+ * Segment consists of fixed-size header followed by payload area.
+ * Header's sequence is odd while segment is being updated (seqlock), so readers retry
+ * if sequence is odd or has changed during the read.
+ * Segment grows if dump does not fit, readers remap it on capacity change.
+ *
+ * "%p" in configured name is replaced with process id (e.g. "/handystats-%p"), so processes
+ * started with the same configuration export into separate segments.
+ * Existing segment is replaced only if its owner process is not alive anymore,
+ * otherwise export is disabled rather than taking over segment of another process.
+ */
+
+namespace handystats { namespace shm_export {
+
+static const char MAGIC[4] = {'H', 'S', 'T', 'S'};
+static const uint32_t VERSION = 1;
+
+struct segment_header {
+	char magic[4];
+	uint32_t version;
+	uint64_t header_size;
+	uint64_t pid;
+
+	std::atomic<uint64_t> sequence;
+	std::atomic<uint64_t> capacity;
+	std::atomic<uint64_t> generation;
+	std::atomic<uint64_t> size;
+} __attribute__((aligned(64)));
+
+// returns segment name with "%p" replaced by pid and "%%" by '%'
+std::string expand_name(const std::string& name, const uint64_t& pid);
+
+class reader {
+public:
+	reader(const std::string& name);
+	~reader();
+
+	// true if segment is successfully mapped
+	bool valid() const;
+
+	/*
+	 * Copies last published dump into data.
+	 * Returns false if segment is invalid, no dump has been published yet,
+	 * or consistent copy could not be made in max_attempts.
+	 */
+	bool read(std::string& data, uint64_t* generation = nullptr, const size_t& max_attempts = 1000);
+
+private:
+	reader(const reader&);
+	reader& operator= (const reader&);
+
+	bool remap(const size_t& size);
+
+	int m_fd;
+	void* m_data;
+	size_t m_size;
+};
+
+}} // namespace handystats::shm_export
+
+#endif // HANDYSTATS_SHM_EXPORT_HPP_
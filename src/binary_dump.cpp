@@ -0,0 +1,595 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <cmath>
+#include <cstring>
+
+#include <handystats/binary_dump.hpp>
+#include <handystats/metrics/gauge.hpp>
+#include <handystats/metrics/counter.hpp>
+#include <handystats/metrics/timer.hpp>
+
+#include "output_stream_impl.hpp"
+#include "config_impl.hpp"
+#include "metrics_dump_impl.hpp"
+#include "dump_filter_impl.hpp"
+
+namespace handystats { namespace binary {
+
+namespace {
+
+const double QUANTILES[] = {0.25, 0.50, 0.75, 0.90, 0.95};
+const size_t QUANTILES_COUNT = sizeof(QUANTILES) / sizeof(QUANTILES[0]);
+
+// largest magnitude of integral double encoded as varint
+const double MAX_INTEGRAL_DOUBLE = 9007199254740992.0; // 2^53
+
+inline uint64_t zigzag_encode(const int64_t& value) {
+	return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+inline int64_t zigzag_decode(const uint64_t& value) {
+	return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+inline int64_t to_msec(const chrono::time_point& timestamp) {
+	const chrono::time_point system_timestamp = chrono::time_point::convert_to(chrono::clock_type::SYSTEM, timestamp);
+	return chrono::duration::convert_to(chrono::time_unit::MSEC, system_timestamp.time_since_epoch()).count();
+}
+
+template <typename OutputStream>
+class writer {
+public:
+	writer(OutputStream& stream)
+		: m_stream(stream)
+		, m_timestamp(0)
+	{}
+
+	void write(const std::map<std::string, metrics::metric_variant>& metrics_map, const metrics_dump::tags_filter& tags_filter) {
+		m_timestamp = dump_timestamp(metrics_map);
+
+		m_stream.Put(MAGIC, sizeof(MAGIC));
+		m_stream.Put(char(VERSION));
+		put_varint(zigzag_encode(m_timestamp));
+		put_varint(metrics_map.size());
+
+		const std::string* previous_name = nullptr;
+		for (auto metric_iter = metrics_map.cbegin(); metric_iter != metrics_map.cend(); ++metric_iter) {
+			put_name(metric_iter->first, previous_name);
+			previous_name = &metric_iter->first;
+
+			m_stream.Put(char(metric_iter->second.which()));
+
+			switch (metric_iter->second.which()) {
+				case metrics::metric_index::GAUGE:
+					put_statistics(boost::get<metrics::gauge>(metric_iter->second).values(), tags_filter(metric_iter->first));
+					break;
+				case metrics::metric_index::COUNTER:
+					put_statistics(boost::get<metrics::counter>(metric_iter->second).values(), tags_filter(metric_iter->first));
+					break;
+				case metrics::metric_index::TIMER:
+					put_statistics(boost::get<metrics::timer>(metric_iter->second).values(), tags_filter(metric_iter->first));
+					break;
+				case metrics::metric_index::ATTRIBUTE:
+					put_attribute(boost::get<metrics::attribute>(metric_iter->second).value());
+					break;
+			}
+		}
+	}
+
+private:
+	static int64_t dump_timestamp(const std::map<std::string, metrics::metric_variant>& metrics_map) {
+		auto timestamp_iter = metrics_map.find("handystats.dump_timestamp");
+		if (timestamp_iter != metrics_map.end() && timestamp_iter->second.which() == metrics::metric_index::ATTRIBUTE) {
+			const auto& value = boost::get<metrics::attribute>(timestamp_iter->second).value();
+			switch (value.which()) {
+				case metrics::attribute::value_index::INT64:
+					return boost::get<int64_t>(value);
+				case metrics::attribute::value_index::UINT64:
+					return boost::get<uint64_t>(value);
+				default:
+					break;
+			}
+		}
+
+		return to_msec(chrono::tsc_clock::now());
+	}
+
+	void put_varint(uint64_t value) {
+		char buffer[10];
+		size_t size = 0;
+		while (value >= 0x80) {
+			buffer[size++] = char((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		buffer[size++] = char(value);
+		m_stream.Put(buffer, size);
+	}
+
+	void put_double(const double& value) {
+		// negative zero is not representable as integer
+		if (value == std::floor(value) && std::fabs(value) < MAX_INTEGRAL_DOUBLE && !(value == 0 && std::signbit(value))) {
+			put_varint(zigzag_encode(int64_t(value)) << 1);
+			return;
+		}
+
+		put_varint(1);
+
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		char buffer[8];
+		for (size_t index = 0; index < 8; ++index) {
+			buffer[index] = char(bits >> (8 * index));
+		}
+		m_stream.Put(buffer, 8);
+	}
+
+	void put_name(const std::string& name, const std::string* previous_name) {
+		size_t prefix = 0;
+		if (previous_name) {
+			const size_t max_prefix = std::min(name.size(), previous_name->size());
+			while (prefix < max_prefix && name[prefix] == (*previous_name)[prefix]) {
+				++prefix;
+			}
+		}
+
+		put_varint(prefix);
+		put_varint(name.size() - prefix);
+		m_stream.Put(name.data() + prefix, name.size() - prefix);
+	}
+
+	void put_statistics(const statistics& values, const statistics::tag::type& tags_filter) {
+		const statistics::tag::type tags = values.tags() & tags_filter;
+		put_varint(tags);
+
+		if (tags & statistics::tag::value) {
+			put_double(values.get<statistics::tag::value>());
+		}
+		if (tags & statistics::tag::min) {
+			put_double(values.get<statistics::tag::min>());
+		}
+		if (tags & statistics::tag::max) {
+			put_double(values.get<statistics::tag::max>());
+		}
+		if (tags & statistics::tag::count) {
+			put_varint(values.get<statistics::tag::count>());
+		}
+		if (tags & statistics::tag::sum) {
+			put_double(values.get<statistics::tag::sum>());
+		}
+		if (tags & statistics::tag::avg) {
+			put_double(values.get<statistics::tag::avg>());
+		}
+		if (tags & statistics::tag::moving_count) {
+			put_double(values.get<statistics::tag::moving_count>());
+		}
+		if (tags & statistics::tag::moving_sum) {
+			put_double(values.get<statistics::tag::moving_sum>());
+		}
+		if (tags & statistics::tag::moving_avg) {
+			put_double(values.get<statistics::tag::moving_avg>());
+		}
+		if (tags & statistics::tag::histogram) {
+			const auto& histogram = values.get<statistics::tag::histogram>();
+			put_varint(histogram.size());
+			for (auto bin = histogram.begin(); bin != histogram.end(); ++bin) {
+				put_double(std::get<statistics::BIN_CENTER>(*bin));
+				put_double(std::get<statistics::BIN_COUNT>(*bin));
+			}
+		}
+		if (tags & statistics::tag::quantile) {
+			const auto quantile = values.get<statistics::tag::quantile>();
+			for (size_t index = 0; index < QUANTILES_COUNT; ++index) {
+				put_double(quantile.at(QUANTILES[index]));
+			}
+		}
+		if (tags & statistics::tag::timestamp) {
+			put_varint(zigzag_encode(to_msec(values.get<statistics::tag::timestamp>()) - m_timestamp));
+		}
+		if (tags & statistics::tag::rate) {
+			put_double(values.get<statistics::tag::rate>());
+		}
+		if (tags & statistics::tag::entropy) {
+			put_double(values.get<statistics::tag::entropy>());
+		}
+	}
+
+	void put_attribute(const metrics::attribute::value_type& value) {
+		m_stream.Put(char(value.which()));
+
+		switch (value.which()) {
+			case metrics::attribute::value_index::BOOL:
+				m_stream.Put(char(boost::get<bool>(value) ? 1 : 0));
+				break;
+			case metrics::attribute::value_index::INT:
+				put_varint(zigzag_encode(boost::get<int>(value)));
+				break;
+			case metrics::attribute::value_index::UINT:
+				put_varint(boost::get<unsigned>(value));
+				break;
+			case metrics::attribute::value_index::INT64:
+				put_varint(zigzag_encode(boost::get<int64_t>(value)));
+				break;
+			case metrics::attribute::value_index::UINT64:
+				put_varint(boost::get<uint64_t>(value));
+				break;
+			case metrics::attribute::value_index::DOUBLE:
+				put_double(boost::get<double>(value));
+				break;
+			case metrics::attribute::value_index::STRING:
+				{
+					const auto& str = boost::get<std::string>(value);
+					put_varint(str.size());
+					m_stream.Put(str.data(), str.size());
+					break;
+				}
+		}
+	}
+
+	OutputStream& m_stream;
+	int64_t m_timestamp;
+};
+
+class reader {
+public:
+	reader(const char* data, const size_t& size)
+		: m_pos(reinterpret_cast<const uint8_t*>(data))
+		, m_end(reinterpret_cast<const uint8_t*>(data) + size)
+	{}
+
+	bool read(snapshot& result) {
+		if (size_t(m_end - m_pos) < sizeof(MAGIC) + 1 || memcmp(m_pos, MAGIC, sizeof(MAGIC)) != 0) {
+			return false;
+		}
+		m_pos += sizeof(MAGIC);
+
+		result.version = *m_pos++;
+		if (result.version != VERSION) {
+			return false;
+		}
+
+		uint64_t timestamp;
+		uint64_t metrics_count;
+		if (!get_varint(timestamp) || !get_varint(metrics_count)) {
+			return false;
+		}
+		result.timestamp = zigzag_decode(timestamp);
+
+		result.metrics.clear();
+
+		std::string name;
+		auto hint = result.metrics.end();
+		for (uint64_t index = 0; index < metrics_count; ++index) {
+			if (!get_name(name)) {
+				return false;
+			}
+
+			uint8_t type;
+			if (!get_byte(type)) {
+				return false;
+			}
+
+			metric_record record;
+			switch (type) {
+				case metrics::metric_index::GAUGE:
+				case metrics::metric_index::COUNTER:
+				case metrics::metric_index::TIMER:
+					record.type = metrics::metric_index(type);
+					if (!get_statistics(record, result.timestamp)) {
+						return false;
+					}
+					break;
+				case metrics::metric_index::ATTRIBUTE:
+					record.type = metrics::metric_index::ATTRIBUTE;
+					if (!get_attribute(record.attribute_value)) {
+						return false;
+					}
+					break;
+				default:
+					return false;
+			}
+
+			hint = result.metrics.insert(hint, std::make_pair(name, std::move(record)));
+		}
+
+		return m_pos == m_end;
+	}
+
+private:
+	bool get_byte(uint8_t& value) {
+		if (m_pos == m_end) {
+			return false;
+		}
+		value = *m_pos++;
+		return true;
+	}
+
+	bool get_varint(uint64_t& value) {
+		value = 0;
+		for (size_t shift = 0; shift < 64; shift += 7) {
+			if (m_pos == m_end) {
+				return false;
+			}
+			const uint8_t byte = *m_pos++;
+			value |= uint64_t(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool get_double(double& value) {
+		uint64_t encoded;
+		if (!get_varint(encoded)) {
+			return false;
+		}
+
+		if (!(encoded & 1)) {
+			value = double(zigzag_decode(encoded >> 1));
+			return true;
+		}
+
+		if (encoded != 1 || m_end - m_pos < 8) {
+			return false;
+		}
+
+		uint64_t bits = 0;
+		for (size_t index = 0; index < 8; ++index) {
+			bits |= uint64_t(m_pos[index]) << (8 * index);
+		}
+		m_pos += 8;
+		memcpy(&value, &bits, sizeof(value));
+		return true;
+	}
+
+	bool get_bytes(std::string& value, const uint64_t& size) {
+		if (uint64_t(m_end - m_pos) < size) {
+			return false;
+		}
+		value.append(reinterpret_cast<const char*>(m_pos), size);
+		m_pos += size;
+		return true;
+	}
+
+	bool get_name(std::string& name) {
+		uint64_t prefix;
+		uint64_t suffix;
+		if (!get_varint(prefix) || !get_varint(suffix) || prefix > name.size()) {
+			return false;
+		}
+		name.resize(prefix);
+		return get_bytes(name, suffix);
+	}
+
+	bool get_statistics(metric_record& record, const int64_t& base_timestamp) {
+		uint64_t tags;
+		if (!get_varint(tags)) {
+			return false;
+		}
+		record.tags = statistics::tag::type(tags);
+
+		if ((tags & statistics::tag::value) && !get_double(record.value)) {
+			return false;
+		}
+		if ((tags & statistics::tag::min) && !get_double(record.min)) {
+			return false;
+		}
+		if ((tags & statistics::tag::max) && !get_double(record.max)) {
+			return false;
+		}
+		if ((tags & statistics::tag::count) && !get_varint(record.count)) {
+			return false;
+		}
+		if ((tags & statistics::tag::sum) && !get_double(record.sum)) {
+			return false;
+		}
+		if ((tags & statistics::tag::avg) && !get_double(record.avg)) {
+			return false;
+		}
+		if ((tags & statistics::tag::moving_count) && !get_double(record.moving_count)) {
+			return false;
+		}
+		if ((tags & statistics::tag::moving_sum) && !get_double(record.moving_sum)) {
+			return false;
+		}
+		if ((tags & statistics::tag::moving_avg) && !get_double(record.moving_avg)) {
+			return false;
+		}
+		if (tags & statistics::tag::histogram) {
+			uint64_t bins;
+			if (!get_varint(bins) || bins > uint64_t(m_end - m_pos)) {
+				return false;
+			}
+			record.histogram.resize(bins);
+			for (uint64_t index = 0; index < bins; ++index) {
+				if (!get_double(record.histogram[index].first) || !get_double(record.histogram[index].second)) {
+					return false;
+				}
+			}
+		}
+		if (tags & statistics::tag::quantile) {
+			record.quantiles.resize(QUANTILES_COUNT);
+			for (size_t index = 0; index < QUANTILES_COUNT; ++index) {
+				record.quantiles[index].first = QUANTILES[index];
+				if (!get_double(record.quantiles[index].second)) {
+					return false;
+				}
+			}
+		}
+		if (tags & statistics::tag::timestamp) {
+			uint64_t delta;
+			if (!get_varint(delta)) {
+				return false;
+			}
+			record.timestamp = base_timestamp + zigzag_decode(delta);
+		}
+		if ((tags & statistics::tag::rate) && !get_double(record.rate)) {
+			return false;
+		}
+		if ((tags & statistics::tag::entropy) && !get_double(record.entropy)) {
+			return false;
+		}
+
+		return true;
+	}
+
+	bool get_attribute(metrics::attribute::value_type& value) {
+		uint8_t index;
+		if (!get_byte(index)) {
+			return false;
+		}
+
+		uint64_t encoded;
+		switch (index) {
+			case metrics::attribute::value_index::BOOL:
+				{
+					uint8_t byte;
+					if (!get_byte(byte)) {
+						return false;
+					}
+					value = bool(byte != 0);
+					return true;
+				}
+			case metrics::attribute::value_index::INT:
+				if (!get_varint(encoded)) {
+					return false;
+				}
+				value = int(zigzag_decode(encoded));
+				return true;
+			case metrics::attribute::value_index::UINT:
+				if (!get_varint(encoded)) {
+					return false;
+				}
+				value = unsigned(encoded);
+				return true;
+			case metrics::attribute::value_index::INT64:
+				if (!get_varint(encoded)) {
+					return false;
+				}
+				value = int64_t(zigzag_decode(encoded));
+				return true;
+			case metrics::attribute::value_index::UINT64:
+				if (!get_varint(encoded)) {
+					return false;
+				}
+				value = uint64_t(encoded);
+				return true;
+			case metrics::attribute::value_index::DOUBLE:
+				{
+					double double_value;
+					if (!get_double(double_value)) {
+						return false;
+					}
+					value = double_value;
+					return true;
+				}
+			case metrics::attribute::value_index::STRING:
+				{
+					std::string str;
+					if (!get_varint(encoded) || !get_bytes(str, encoded)) {
+						return false;
+					}
+					value = str;
+					return true;
+				}
+			default:
+				return false;
+		}
+	}
+
+	const uint8_t* m_pos;
+	const uint8_t* const m_end;
+};
+
+} // unnamed namespace
+
+metric_record::metric_record()
+	: type(metrics::metric_index::GAUGE)
+	, tags(statistics::tag::empty)
+	, value(0)
+	, min(0)
+	, max(0)
+	, count(0)
+	, sum(0)
+	, avg(0)
+	, moving_count(0)
+	, moving_sum(0)
+	, moving_avg(0)
+	, histogram()
+	, quantiles()
+	, timestamp(0)
+	, rate(0)
+	, entropy(0)
+	, attribute_value()
+{}
+
+snapshot::snapshot()
+	: version(0)
+	, timestamp(0)
+	, metrics()
+{}
+
+std::string to_string(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map) {
+	std::string buffer;
+	write_to_string(metrics_map, buffer);
+	return buffer;
+}
+
+void write_to_string(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, std::string& buffer) {
+	string_output_stream stream(buffer);
+	writer<string_output_stream>(stream).write(metrics_map, metrics_dump::tags_filter());
+}
+
+void write_to_string(
+		const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, std::string& buffer,
+		const metrics_dump::tags_filter& tags_filter
+	)
+{
+	string_output_stream stream(buffer);
+	writer<string_output_stream>(stream).write(metrics_map, tags_filter);
+}
+
+bool write_to_fd(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, const int& fd) {
+	fd_output_stream stream(fd);
+	writer<fd_output_stream>(stream).write(metrics_map, metrics_dump::tags_filter());
+	stream.Flush();
+	return !stream.failed;
+}
+
+bool decode(const char* data, const size_t& size, snapshot& result) {
+	return reader(data, size).read(result);
+}
+
+bool decode(const std::string& data, snapshot& result) {
+	return decode(data.data(), data.size(), result);
+}
+
+}} // namespace handystats::binary
+
+std::shared_ptr<const std::string> HANDY_BINARY_DUMP_SHARED() {
+	auto rendered_dump = handystats::metrics_dump::get_rendered_dump(handystats::config::dump_format::BINARY);
+	if (rendered_dump) {
+		return rendered_dump;
+	}
+
+	return std::shared_ptr<const std::string>(new std::string(handystats::binary::to_string(*HANDY_METRICS_DUMP())));
+}
+
+std::string HANDY_BINARY_DUMP() {
+	return *HANDY_BINARY_DUMP_SHARED();
+}
@@ -22,6 +22,8 @@
 #include <handystats/chrono.h>
 #include <handystats/chrono.hpp>
 
+#include "chrono_impl.hpp"
+
 namespace handystats { namespace chrono {
 
 static
@@ -46,25 +48,41 @@ inline uint64_t nsec_factor(const time_unit& unit) {
 	return 0ull;
 }
 
-extern long double cycles_per_nanosec;
-
 duration duration::convert_to(const time_unit& to_unit, const duration& d) {
 	if (d.m_unit == to_unit) return d;
 
 	if (to_unit == time_unit::TICK) {
-		return duration(int64_t(cycles_per_nanosec * nsec_factor(d.m_unit) * d.m_rep), to_unit);
+		ensure_cycles_per_nanosec();
+		return duration(nsec_to_ticks(int64_t(nsec_factor(d.m_unit) * d.m_rep)), to_unit);
 	}
 
 	if (d.m_unit == time_unit::TICK) {
-		return duration(int64_t(double(d.m_rep) / nsec_factor(to_unit) / cycles_per_nanosec), to_unit);
+		ensure_cycles_per_nanosec();
+		return duration(ticks_to_nsec(d.m_rep) / int64_t(nsec_factor(to_unit)), to_unit);
 	}
 
 	return duration(nsec_factor(d.m_unit) * d.m_rep / nsec_factor(to_unit), to_unit);
 }
 
 /* Conversion to system time */
+static
+inline int64_t absolute_nsec(const time_point& t) {
+	const duration& d = t.time_since_epoch();
+
+	if (d.unit() == time_unit::TICK) {
+		ensure_cycles_per_nanosec();
+
+		// anchored conversion is continuous across TSC frequency updates
+		return anchored_ticks_to_nsec(load_tsc_anchor(), d.count());
+	}
+
+	return duration::convert_to(time_unit::NSEC, d).count();
+}
+
 static
 time_point to_system_time(const time_point& t) {
+	// offset is single value, as anchored conversion doesn't jump on frequency update
+	// offset could be combined with any anchor
 	static std::atomic<int64_t> ns_offset(0);
 	static std::atomic<int64_t> offset_timestamp(0);
 	static std::atomic_flag lock = ATOMIC_FLAG_INIT;
@@ -101,11 +119,7 @@ time_point to_system_time(const time_point& t) {
 			if (close_pair_found) {
 				time_point cycles_middle = cycles_start + (cycles_end - cycles_start) / 2;
 				int64_t new_offset =
-					duration::convert_to(
-						time_unit::NSEC,
-						current_system_time.time_since_epoch() - cycles_middle.time_since_epoch()
-					)
-					.count();
+					current_system_time.time_since_epoch().count() - absolute_nsec(cycles_middle);
 
 				ns_offset.store(new_offset, std::memory_order_release);
 				offset_timestamp.store(cycles_middle.time_since_epoch().count(), std::memory_order_release);
@@ -117,10 +131,7 @@ time_point to_system_time(const time_point& t) {
 
 	return
 		time_point(
-			duration::convert_to(
-				time_unit::NSEC,
-				t.time_since_epoch() + duration(ns_offset.load(std::memory_order_acquire), time_unit::NSEC)
-			),
+			duration(absolute_nsec(t) + ns_offset.load(std::memory_order_acquire), time_unit::NSEC),
 			clock_type::SYSTEM
 		);
 }
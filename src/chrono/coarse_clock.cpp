@@ -0,0 +1,88 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+#include <thread>
+#include <sys/prctl.h>
+
+#include <handystats/atomic.hpp>
+#include <handystats/chrono.hpp>
+
+#include "chrono_impl.hpp"
+
+namespace {
+
+// 0 means no cached time_point
+std::atomic<int64_t> cached_rep(0);
+std::atomic<int> cached_unit((int)handystats::chrono::time_unit::TICK);
+
+std::atomic<bool> refresher_running(false);
+std::thread refresher_thread;
+
+void update_coarse_clock(const handystats::chrono::time_point& t) {
+	cached_unit.store((int)t.time_since_epoch().unit(), std::memory_order_relaxed);
+	cached_rep.store(t.time_since_epoch().count(), std::memory_order_release);
+}
+
+// refreshes cached time_point on its own period,
+// so it doesn't go stale while processing thread is busy with dumps
+void run_refresher() {
+	prctl(PR_SET_NAME, "handystats-clk");
+	// default timer slack (50us) would double the refresh period
+	prctl(PR_SET_TIMERSLACK, 1UL);
+
+	while (refresher_running.load(std::memory_order_acquire)) {
+		update_coarse_clock(handystats::chrono::tsc_clock::now());
+		std::this_thread::sleep_for(handystats::chrono::COARSE_CLOCK_REFRESH_INTERVAL);
+	}
+}
+
+} // unnamed namespace
+
+
+namespace handystats { namespace chrono {
+
+time_point coarse_clock::now() {
+	const int64_t rep = cached_rep.load(std::memory_order_acquire);
+
+	if (rep == 0) {
+		return tsc_clock::now();
+	}
+
+	return time_point(duration(rep, (time_unit)cached_unit.load(std::memory_order_relaxed)), clock_type::TSC);
+}
+
+void start_coarse_clock() {
+	if (refresher_running.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	update_coarse_clock(tsc_clock::now());
+
+	refresher_running.store(true, std::memory_order_release);
+	refresher_thread = std::thread(run_refresher);
+}
+
+void stop_coarse_clock() {
+	refresher_running.store(false, std::memory_order_release);
+
+	if (refresher_thread.joinable()) {
+		refresher_thread.join();
+	}
+
+	cached_rep.store(0, std::memory_order_release);
+}
+
+}} // namespace handystats::chrono
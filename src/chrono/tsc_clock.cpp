@@ -16,16 +16,19 @@
 */
 
 #include <cstring>
+#include <cstdio>
 #include <cstdlib>
 #include <cstdint>
-#include <cassert>
 #include <algorithm>
+#include <mutex>
 #include <ctime>
 #include <unistd.h>
 
 #include <handystats/chrono.hpp>
+#include <handystats/metrics/gauge.hpp>
 
 #include "cpuid_impl.hpp"
+#include "chrono_impl.hpp"
 
 namespace handystats { namespace chrono {
 
@@ -41,6 +44,30 @@ inline uint64_t rdtsc() {
 	return tsc;
 }
 
+inline uint64_t rdtsc_lfence() {
+	uint64_t tsc;
+	asm volatile (
+			"lfence; rdtsc; "
+			"shl $32,%%rdx; "
+			"or %%rdx,%%rax "
+			: "=a"(tsc)
+			:
+			: "%rcx", "%rdx");
+	return tsc;
+}
+
+inline uint64_t rdtsc_unfenced() {
+	uint64_t tsc;
+	asm volatile (
+			"rdtsc; "
+			"shl $32,%%rdx; "
+			"or %%rdx,%%rax "
+			: "=a"(tsc)
+			:
+			: "%rcx", "%rdx");
+	return tsc;
+}
+
 inline uint64_t rdtscp() {
 	uint64_t tsc;
 	asm volatile (
@@ -54,6 +81,85 @@ inline uint64_t rdtscp() {
 }
 
 long double cycles_per_nanosec;
+std::atomic<uint64_t> nsec_per_tick_mult(0);
+std::atomic<uint64_t> ticks_per_nsec_mult(0);
+std::atomic<bool> cycles_per_nanosec_initialized(false);
+
+// tsc_anchor fields published under seqlock, sequence is odd while update is in progress
+std::atomic<uint64_t> anchor_sequence(0);
+std::atomic<int64_t> anchor_base_ticks(0);
+std::atomic<int64_t> anchor_base_nsec(0);
+std::atomic<uint64_t> anchor_mult(0);
+
+tsc_anchor load_tsc_anchor() {
+	tsc_anchor anchor;
+	uint64_t sequence;
+
+	do {
+		sequence = anchor_sequence.load(std::memory_order_acquire);
+
+		anchor.base_ticks = anchor_base_ticks.load(std::memory_order_relaxed);
+		anchor.base_nsec = anchor_base_nsec.load(std::memory_order_relaxed);
+		anchor.mult = anchor_mult.load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((sequence & 1) || sequence != anchor_sequence.load(std::memory_order_relaxed));
+
+	return anchor;
+}
+
+static
+void store_tsc_anchor(const tsc_anchor& anchor) {
+	// single writer
+	const uint64_t sequence = anchor_sequence.load(std::memory_order_relaxed);
+
+	anchor_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	anchor_base_ticks.store(anchor.base_ticks, std::memory_order_relaxed);
+	anchor_base_nsec.store(anchor.base_nsec, std::memory_order_relaxed);
+	anchor_mult.store(anchor.mult, std::memory_order_relaxed);
+
+	anchor_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+long double provisional_cycles_per_nanosec(
+		const long double& cpuid_frequency,
+		long double (*cpuinfo_frequency)(),
+		long double (*measure)()
+	)
+{
+	if (cpuid_frequency > 0) {
+		return cpuid_frequency;
+	}
+
+	const long double nominal = cpuinfo_frequency();
+	if (nominal > 0) {
+		return nominal;
+	}
+
+	return measure();
+}
+
+uint64_t tsc_refine_interval(const size_t& step) {
+	static const uint64_t REFINE_INTERVALS[TSC_REFINE_STEPS] = {
+		(uint64_t)1E7, // 10ms
+		(uint64_t)1E8, // 100ms
+		(uint64_t)1E9  // 1s
+	};
+
+	return (step < TSC_REFINE_STEPS) ? REFINE_INTERVALS[step] : TSC_RECALIBRATION_INTERVAL;
+}
+
+long double slew_cycles_per_nanosec(const long double& estimate, const long double& measured, long double* drift_ppm) {
+	*drift_ppm = (estimate - measured) / measured * 1E6L;
+
+	if (*drift_ppm > TSC_MAX_SLEW_DRIFT_PPM || *drift_ppm < -TSC_MAX_SLEW_DRIFT_PPM) {
+		return measured;
+	}
+
+	return estimate + (measured - estimate) * TSC_SLEW_FACTOR;
+}
 
 }} // namespace handystats::chrono
 
@@ -68,6 +174,38 @@ enum clock_source_t {
 	CS_CLOCK_REALTIME
 };
 
+// Ordering of RDTSC relative to preceding instructions
+enum tsc_fence_t {
+	TF_MFENCE,
+	TF_LFENCE,
+	TF_NONE
+};
+
+bool get_tsc_fence(tsc_fence_t* fence) {
+	// check HANDY_TSC_FENCE env variable.
+	// possible values:
+	// - MFENCE (all preceding loads and stores are completed before TSC read)
+	// - LFENCE (all preceding instructions are completed before TSC read)
+	// - NONE (TSC read may be reordered, suitable for coarse timestamps)
+	//
+	// if invalid value is passed TF_MFENCE will be used.
+
+	if (const char* env_tsc_fence = std::getenv("HANDY_TSC_FENCE")) {
+		if (strcmp(env_tsc_fence, "LFENCE") == 0) {
+			*fence = TF_LFENCE;
+		}
+		else if (strcmp(env_tsc_fence, "NONE") == 0) {
+			*fence = TF_NONE;
+		}
+		else {
+			*fence = TF_MFENCE;
+		}
+		return true;
+	}
+
+	return false;
+}
+
 clock_source_t get_available_clock_source() {
 	// check HANDY_CLOCK_SOURCE env variable first.
 	// possible values:
@@ -97,7 +235,9 @@ clock_source_t get_available_clock_source() {
 
 	if (handystats::tsc_supported() && handystats::invariant_tsc())
 	{
-		if (handystats::rdtscp_supported()) {
+		// explicitly requested fence implies RDTSC
+		tsc_fence_t fence;
+		if (handystats::rdtscp_supported() && !get_tsc_fence(&fence)) {
 			return CS_RDTSCP;
 		}
 		else {
@@ -115,11 +255,67 @@ clock_source_t get_available_clock_source() {
 	}
 }
 
+template <uint64_t (*read_tsc)()>
+handystats::chrono::time_point tsc_now() {
+	using namespace handystats::chrono;
+
+	return time_point(duration(read_tsc(), time_unit::TICK), clock_type::TSC);
+}
+
+template <clockid_t posix_clock>
+handystats::chrono::time_point posix_clock_now() {
+	using namespace handystats::chrono;
+
+	timespec tm;
+
+	clock_gettime(posix_clock, &tm);
+
+	return time_point(duration((int64_t)tm.tv_sec * (int64_t)1E9 + tm.tv_nsec, time_unit::NSEC), clock_type::TSC);
+}
+
 clock_source_t clock_source;
 
+// resolved once on load, so that tsc_clock::now doesn't branch on clock source
+uint64_t (*read_cycles)() = &handystats::chrono::rdtsc;
+handystats::chrono::time_point (*now_function)() = &tsc_now<&handystats::chrono::rdtsc>;
+
 __attribute__((constructor(150)))
 void init_clock_source() {
 	clock_source = get_available_clock_source();
+
+	switch (clock_source) {
+	case CS_RDTSC:
+		{
+			tsc_fence_t fence = TF_MFENCE;
+			get_tsc_fence(&fence);
+
+			switch (fence) {
+			case TF_LFENCE:
+				read_cycles = &handystats::chrono::rdtsc_lfence;
+				now_function = &tsc_now<&handystats::chrono::rdtsc_lfence>;
+				break;
+			case TF_NONE:
+				read_cycles = &handystats::chrono::rdtsc_unfenced;
+				now_function = &tsc_now<&handystats::chrono::rdtsc_unfenced>;
+				break;
+			default:
+				read_cycles = &handystats::chrono::rdtsc;
+				now_function = &tsc_now<&handystats::chrono::rdtsc>;
+				break;
+			}
+			break;
+		}
+	case CS_RDTSCP:
+		read_cycles = &handystats::chrono::rdtscp;
+		now_function = &tsc_now<&handystats::chrono::rdtscp>;
+		break;
+	case CS_CLOCK_MONOTONIC:
+		now_function = &posix_clock_now<CLOCK_MONOTONIC>;
+		break;
+	case CS_CLOCK_REALTIME:
+		now_function = &posix_clock_now<CLOCK_REALTIME>;
+		break;
+	}
 }
 
 
@@ -140,12 +336,7 @@ uint64_t get_nanoseconds() {
 }
 
 uint64_t get_cycles_count() {
-	if (clock_source == CS_RDTSC) {
-		return handystats::chrono::rdtsc();
-	}
-	else {
-		return handystats::chrono::rdtscp();
-	}
+	return read_cycles();
 }
 
 
@@ -169,35 +360,86 @@ long double get_cycles_frequency(const timespec& sleep_interval) {
 
 	get_simultaneous_pair(&cycles_start, &nanoseconds_start);
 
-	assert(nanosleep(&sleep_interval, NULL) == 0);
+	nanosleep(&sleep_interval, NULL);
 
 	get_simultaneous_pair(&cycles_end, &nanoseconds_end);
 
 	return (long double)(cycles_end - cycles_start) / (nanoseconds_end - nanoseconds_start);
 }
 
-void estimate_cycles_frequency() {
+// single 1ms measurement, used on first use only if frequency is not known otherwise
+long double measure_cycles_frequency() {
 	const timespec sleep_interval = {0, (long)1E6}; // 1ms
+	return get_cycles_frequency(sleep_interval);
+}
+
+// nominal frequency from "model name" line of /proc/cpuinfo (e.g. "... @ 2.00GHz"), 0 if not found
+long double get_cpuinfo_cycles_frequency() {
+	FILE* cpuinfo = fopen("/proc/cpuinfo", "r");
+	if (!cpuinfo) {
+		return 0;
+	}
 
-	const int TESTS_COUNT = 15;
-	long double cycles_tests[TESTS_COUNT];
+	long double cycles_per_nanosec = 0;
 
-	for (int test = 0; test < TESTS_COUNT; ++test) {
-		cycles_tests[test] = get_cycles_frequency(sleep_interval);
+	char line[512];
+	while (fgets(line, sizeof(line), cpuinfo)) {
+		if (strncmp(line, "model name", strlen("model name")) != 0) {
+			continue;
+		}
+
+		const char* frequency = strrchr(line, '@');
+		double ghz = 0;
+		if (frequency && sscanf(frequency, "@ %lfGHz", &ghz) == 1 && ghz > 0) {
+			cycles_per_nanosec = ghz;
+		}
+		break;
 	}
 
-	std::sort(cycles_tests, cycles_tests + TESTS_COUNT);
-	handystats::chrono::cycles_per_nanosec = cycles_tests[TESTS_COUNT / 2];
+	fclose(cpuinfo);
+
+	return cycles_per_nanosec;
 }
 
-__attribute__((constructor(200)))
-void init_cycles_per_nanosec() {
-	if (clock_source == CS_RDTSC || clock_source == CS_RDTSCP) {
-		estimate_cycles_frequency();
+/*
+ * TSC frequency is calibrated lazily.
+ *
+ * Nothing is done on load. On first conversion (or first iteration of handystats core's processing thread)
+ * provisional frequency is taken from CPUID, /proc/cpuinfo or a single 1ms measurement
+ * and simultaneous pair of cycles count and nanoseconds is remembered.
+ * Later the frequency is refined by the processing thread
+ * from the time elapsed since that pair, no sleeps are involved.
+ * Without running core (no HANDY_INIT) the provisional frequency is kept.
+ *
+ * Once refined, the frequency is measured over each TSC_RECALIBRATION_INTERVAL
+ * and the estimate is slewed toward measured value by TSC_SLEW_FACTOR,
+ * so the estimate follows drift without steps in converted durations.
+ */
+bool calibration_enabled = false;
+uint64_t calibration_start_cycles;
+uint64_t calibration_start_nanoseconds;
+size_t refine_step = 0;
+
+std::once_flag provisional_once;
+
+void init_provisional_cycles_per_nanosec() {
+	if (clock_source != CS_RDTSC && clock_source != CS_RDTSCP) {
+		handystats::chrono::set_cycles_per_nanosec(3);
 	}
 	else {
-		handystats::chrono::cycles_per_nanosec = 3;
+		handystats::chrono::set_cycles_per_nanosec(
+				handystats::chrono::provisional_cycles_per_nanosec(
+					handystats::tsc_frequency() / 1E9L,
+					&get_cpuinfo_cycles_frequency,
+					&measure_cycles_frequency
+				)
+			);
+
+		get_simultaneous_pair(&calibration_start_cycles, &calibration_start_nanoseconds);
+		calibration_enabled = true;
 	}
+
+	handystats::chrono::cycles_per_nanosec_initialized.store(true, std::memory_order_release);
 }
 
 } // unnamed namespace
@@ -206,36 +448,87 @@ void init_cycles_per_nanosec() {
 namespace handystats { namespace chrono {
 
 time_point tsc_clock::now() {
-	switch (clock_source) {
-	case CS_RDTSC:
-		{
-			return time_point(duration(rdtsc(), time_unit::TICK), clock_type::TSC);
-		}
-	case CS_RDTSCP:
-		{
-			return time_point(duration(rdtscp(), time_unit::TICK), clock_type::TSC);
-		}
-	case CS_CLOCK_MONOTONIC:
-		{
-			timespec tm;
+	return now_function();
+}
 
-			clock_gettime(CLOCK_MONOTONIC, &tm);
+void init_cycles_per_nanosec() {
+	std::call_once(provisional_once, &init_provisional_cycles_per_nanosec);
+}
 
-			return time_point(duration((int64_t)tm.tv_sec * (int64_t)1E9 + tm.tv_nsec, time_unit::NSEC), clock_type::TSC);
-		}
-	case CS_CLOCK_REALTIME:
-		{
-			timespec tm;
+void set_cycles_per_nanosec(const long double& value) {
+	const long double one = (long double)((uint64_t)1 << SCALE_SHIFT);
+	const uint64_t nsec_per_tick = uint64_t(one / value + 0.5L);
 
-			clock_gettime(CLOCK_REALTIME, &tm);
+	cycles_per_nanosec = value;
+	nsec_per_tick_mult.store(nsec_per_tick, std::memory_order_relaxed);
+	ticks_per_nsec_mult.store(uint64_t(one * value + 0.5L), std::memory_order_relaxed);
 
-			return time_point(duration((int64_t)tm.tv_sec * (int64_t)1E9 + tm.tv_nsec, time_unit::NSEC), clock_type::TSC);
-		}
-	default:
-		{
-			return time_point(duration(0, time_unit::NSEC), clock_type::TSC);
-		}
+	store_tsc_anchor(rebase_tsc_anchor(load_tsc_anchor(), now_function().time_since_epoch().count(), nsec_per_tick));
+}
+
+bool tsc_calibration_enabled() {
+	return calibration_enabled;
+}
+
+void refine_cycles_per_nanosec() {
+	ensure_cycles_per_nanosec();
+
+	if (!calibration_enabled) {
+		return;
+	}
+
+	const uint64_t interval = tsc_refine_interval(refine_step);
+
+	const int64_t elapsed_cycles = get_cycles_count() - calibration_start_cycles;
+	if (ticks_to_nsec(elapsed_cycles) < (int64_t)interval) {
+		return;
+	}
+
+	uint64_t cycles, nanoseconds;
+	get_simultaneous_pair(&cycles, &nanoseconds);
+
+	const long double measured =
+		(long double)(cycles - calibration_start_cycles) / (nanoseconds - calibration_start_nanoseconds);
+
+	if (refine_step < TSC_REFINE_STEPS) {
+		// initial refinement, measured from provisional pair
+		set_cycles_per_nanosec(measured);
+		++refine_step;
+		return;
 	}
+
+	long double drift_ppm;
+	set_cycles_per_nanosec(slew_cycles_per_nanosec(cycles_per_nanosec, measured, &drift_ppm));
+
+	stats::tsc_drift.set((double)drift_ppm, time_point(duration(cycles, time_unit::TICK), clock_type::TSC));
+
+	calibration_start_cycles = cycles;
+	calibration_start_nanoseconds = nanoseconds;
+}
+
+namespace stats {
+
+metrics::gauge tsc_drift;
+
+void update(const time_point& timestamp) {
+	tsc_drift.update_statistics(timestamp);
 }
 
+static void reset() {
+	config::metrics::gauge tsc_drift_opts;
+	tsc_drift_opts.values.tags = statistics::tag::value;
+
+	tsc_drift = metrics::gauge(tsc_drift_opts);
+}
+
+void initialize() {
+	reset();
+}
+
+void finalize() {
+	reset();
+}
+
+} // namespace stats
+
 }} // namespace handystats::chrono
@@ -0,0 +1,180 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_CHRONO_IMPL_HPP_
+#define HANDYSTATS_CHRONO_IMPL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+
+#include <handystats/atomic.hpp>
+#include <handystats/chrono.hpp>
+#include <handystats/metrics/gauge.hpp>
+
+namespace handystats { namespace chrono {
+
+/*
+ * Fixed-point TSC scale.
+ *
+ * nanoseconds = (ticks * nsec_per_tick_mult) >> SCALE_SHIFT
+ * ticks = (nanoseconds * ticks_per_nsec_mult) >> SCALE_SHIFT
+ *
+ * Shift is constant, so each conversion reads single multiplier and
+ * multipliers could be updated concurrently with conversions.
+ * Both multipliers fit into 64 bits while frequency stays in (1/256, 256) GHz.
+ */
+const unsigned SCALE_SHIFT = 56;
+
+extern std::atomic<uint64_t> nsec_per_tick_mult;
+extern std::atomic<uint64_t> ticks_per_nsec_mult;
+
+// current estimate of TSC frequency, updated with set_cycles_per_nanosec
+extern long double cycles_per_nanosec;
+
+// sets TSC frequency estimate and recomputes multipliers
+void set_cycles_per_nanosec(const long double&);
+
+// provisional TSC frequency is set on first use instead of load-time,
+// so that binaries not converting ticks never pay for it
+extern std::atomic<bool> cycles_per_nanosec_initialized;
+
+// sets provisional TSC frequency once, may sleep for 1ms if frequency is not known otherwise
+void init_cycles_per_nanosec();
+
+inline void ensure_cycles_per_nanosec() {
+	if (!cycles_per_nanosec_initialized.load(std::memory_order_acquire)) {
+		init_cycles_per_nanosec();
+	}
+}
+
+// refines TSC frequency estimate once enough time has passed since provisional one was set
+// and keeps recalibrating it afterwards, called by processing thread
+void refine_cycles_per_nanosec();
+
+// whether TSC frequency is calibrated, i.e. clock source is RDTSC or RDTSCP
+// and provisional frequency is set
+bool tsc_calibration_enabled();
+
+// provisional frequency taken on first use: CPUID value if known, else /proc/cpuinfo nominal frequency,
+// else the value returned by measure (non-positive values mean unknown),
+// sources are queried lazily in that order
+long double provisional_cycles_per_nanosec(
+		const long double& cpuid_frequency,
+		long double (*cpuinfo_frequency)(),
+		long double (*measure)()
+	);
+
+// provisional estimate is refined from the pair of cycles count and nanoseconds
+// after each of TSC_REFINE_STEPS intervals (10ms, 100ms, 1s)
+const size_t TSC_REFINE_STEPS = 3;
+
+// TSC frequency is measured over each TSC_RECALIBRATION_INTERVAL once refined
+// and the estimate is slewed toward measured value by TSC_SLEW_FACTOR
+const uint64_t TSC_RECALIBRATION_INTERVAL = (uint64_t)1E10; // 10s
+const long double TSC_SLEW_FACTOR = 0.25L;
+// estimate is reset to measured value if drift exceeds this value (e.g. after VM migration)
+const long double TSC_MAX_SLEW_DRIFT_PPM = 1000;
+
+// nanoseconds to wait since previous calibration point before calibration step
+uint64_t tsc_refine_interval(const size_t& step);
+
+// one recalibration step, returns new estimate
+// and stores deviation of the estimate from measured frequency (ppm) in drift_ppm
+long double slew_cycles_per_nanosec(const long double& estimate, const long double& measured, long double* drift_ppm);
+
+// 128-bit intermediate for fixed-point multiplication (GCC extension)
+__extension__ typedef unsigned __int128 uint128_t;
+
+// returns (value * mult) >> SCALE_SHIFT rounded toward zero
+inline int64_t scale(const int64_t& value, const uint64_t& mult) {
+	if (value >= 0) {
+		return int64_t((uint128_t(value) * mult) >> SCALE_SHIFT);
+	}
+	else {
+		const uint64_t magnitude = uint64_t(0) - uint64_t(value);
+		return -int64_t((uint128_t(magnitude) * mult) >> SCALE_SHIFT);
+	}
+}
+
+inline int64_t ticks_to_nsec(const int64_t& ticks) {
+	return scale(ticks, nsec_per_tick_mult.load(std::memory_order_relaxed));
+}
+
+inline int64_t nsec_to_ticks(const int64_t& nsec) {
+	return scale(nsec, ticks_per_nsec_mult.load(std::memory_order_relaxed));
+}
+
+/*
+ * Anchor of absolute cycles count to nanoseconds conversion.
+ *
+ * nanoseconds = base_nsec + ((ticks - base_ticks) * mult) >> SCALE_SHIFT
+ *
+ * Durations are converted with multipliers only, while absolute time points
+ * (e.g. on conversion to system time) are converted relative to the anchor.
+ * Each frequency update takes new anchor at current cycles count with base_nsec computed by previous anchor,
+ * so that converted absolute time stays continuous instead of moving by uptime * frequency change.
+ * The anchor is published under seqlock by single writer (first-use initializer or processing thread).
+ */
+struct tsc_anchor {
+	int64_t base_ticks;
+	int64_t base_nsec;
+	uint64_t mult;
+};
+
+// consistent snapshot of current anchor
+tsc_anchor load_tsc_anchor();
+
+inline int64_t anchored_ticks_to_nsec(const tsc_anchor& anchor, const int64_t& ticks) {
+	return anchor.base_nsec + scale(ticks - anchor.base_ticks, anchor.mult);
+}
+
+// anchor taken at ticks for new multiplier, continuous with the current one at that point
+inline tsc_anchor rebase_tsc_anchor(const tsc_anchor& current, const int64_t& ticks, const uint64_t& mult) {
+	tsc_anchor anchor;
+	anchor.base_ticks = ticks;
+	anchor.base_nsec = anchored_ticks_to_nsec(current, ticks);
+	anchor.mult = mult;
+	return anchor;
+}
+
+// period of coarse_clock's cached time_point refresh
+const std::chrono::microseconds COARSE_CLOCK_REFRESH_INTERVAL(50);
+
+// starts thread that refreshes coarse_clock's cached time_point each COARSE_CLOCK_REFRESH_INTERVAL
+void start_coarse_clock();
+
+// stops refreshing thread and drops coarse_clock's cached time_point,
+// coarse_clock falls back to tsc_clock
+void stop_coarse_clock();
+
+namespace stats {
+
+// deviation of TSC frequency estimate from frequency measured on last recalibration, in ppm
+// dumped only while TSC calibration is enabled
+extern metrics::gauge tsc_drift;
+
+void update(const time_point&);
+
+void initialize();
+void finalize();
+
+} // namespace stats
+
+}} // namespace handystats::chrono
+
+#endif // HANDYSTATS_CHRONO_IMPL_HPP_
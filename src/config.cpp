@@ -21,8 +21,6 @@
 #include <iostream>
 #include <sstream>
 
-#include <fnmatch.h>
-
 #include <handystats/core.hpp>
 #include <handystats/core.h>
 
@@ -33,6 +31,7 @@
 #include "core_impl.hpp"
 
 #include "config_impl.hpp"
+#include "events/event_message_impl.hpp"
 
 namespace handystats { namespace config {
 
@@ -122,18 +121,22 @@ std::vector<std::string> expand_pattern(const std::string& pattern) {
 	}
 }
 
-rapidjson::Value* select_pattern(const std::string& name) {
-	for (auto pattern_group_iter = pattern_opts.begin(); pattern_group_iter != pattern_opts.end(); ++pattern_group_iter) {
-		auto& pattern_group = pattern_group_iter->first;
-		auto* pattern_cfg = pattern_group_iter->second;
-		for (auto pattern_iter = pattern_group.begin(); pattern_iter != pattern_group.end(); ++pattern_iter) {
-			if (fnmatch(pattern_iter->c_str(), name.c_str(), 0) == 0) {
-				return pattern_cfg;
-			}
-		}
+const pattern_options* select_pattern(const std::string& name) {
+	const size_t pattern_group = pattern_opts_matcher.match(name);
+	if (pattern_group == pattern_matcher::npos) {
+		return nullptr;
+	}
+
+	return &pattern_opts[pattern_group].second;
+}
+
+handystats::statistics::tag::type select_dump_tags(const std::string& name) {
+	const size_t pattern_group = dump_filter_matcher.match(name);
+	if (pattern_group == pattern_matcher::npos) {
+		return ~handystats::statistics::tag::empty;
 	}
 
-	return nullptr;
+	return dump_filter_opts[pattern_group].second;
 }
 
 
@@ -147,15 +150,31 @@ namespace metrics {
 
 metrics_dump metrics_dump_opts;
 core core_opts;
+// hold std::string, should be constructed before init_opts() resets them
+shm_export shm_export_opts __attribute__((init_priority(250)));
+push_export push_export_opts __attribute__((init_priority(250)));
+registry registry_opts;
 
 std::vector<
 	std::pair<
 		std::vector<std::string>,
-		rapidjson::Value*
+		pattern_options
 	>
 >
 pattern_opts;
 
+std::vector<
+	std::pair<
+		std::vector<std::string>,
+		handystats::statistics::tag::type
+	>
+>
+dump_filter_opts;
+
+// compiled pattern_opts and dump_filter_opts patterns, match returns index of pattern group
+pattern_matcher pattern_opts_matcher __attribute__((init_priority(250)));
+pattern_matcher dump_filter_matcher __attribute__((init_priority(250)));
+
 std::shared_ptr<rapidjson::Document> source(new rapidjson::Document());
 
 static void reset() {
@@ -167,8 +186,14 @@ static void reset() {
 
 	metrics_dump_opts = metrics_dump();
 	core_opts = core();
+	shm_export_opts = shm_export();
+	push_export_opts = push_export();
+	registry_opts = registry();
 
 	pattern_opts.clear();
+	dump_filter_opts.clear();
+	pattern_opts_matcher.clear();
+	dump_filter_matcher.clear();
 	source.reset(new rapidjson::Document());
 }
 
@@ -242,7 +267,8 @@ bool config_json(const char* config_data) {
 	 *   },
 	 *
 	 *   "metrics-dump": {
-	 *     "interval": ...
+	 *     "interval": ...,
+	 *     "formats": [...]
 	 *   },
 	 *
 	 *   "core": {
@@ -307,6 +333,19 @@ bool config_json(const char* config_data) {
 	 *   },
 	 *
 	 *   "dump-interval": ...,
+	 *   "dump-formats": [...],
+	 *   "dump-filter": {
+	 *     "<pattern>": ["<tag name>", ...],
+	 *     ...
+	 *   },
+	 *
+	 *   "shm-export": ...,
+	 *   "push-export": ...,
+	 *
+	 *   "registry": {
+	 *     "ttl": ...,
+	 *     "max-size": ...
+	 *   },
 	 *
 	 *   "enable": ...
 	 * }
@@ -347,6 +386,55 @@ bool config_json(const char* config_data) {
 		}
 	}
 
+	if (cfg.HasMember("dump-formats")) {
+		config::metrics_dump_opts.configure_formats(cfg["dump-formats"]);
+	}
+
+
+	if (cfg.HasMember("dump-filter")) {
+		const rapidjson::Value& dump_filter = cfg["dump-filter"];
+
+		if (dump_filter.IsObject()) {
+			for (auto filter_member = dump_filter.MemberBegin(); filter_member != dump_filter.MemberEnd(); ++filter_member) {
+				const rapidjson::Value& filter_tags = filter_member->value;
+				if (!filter_tags.IsArray()) {
+					continue;
+				}
+
+				handystats::statistics::tag::type tags = handystats::statistics::tag::empty;
+				for (size_t index = 0; index < filter_tags.Size(); ++index) {
+					const rapidjson::Value& tag = filter_tags[index];
+					if (tag.IsString()) {
+						tags |= handystats::statistics::tag::from_string(tag.GetString());
+					}
+				}
+
+				try {
+					std::vector<std::string> expansion = config::expand_pattern(filter_member->name.GetString());
+
+					for (auto pattern_iter = expansion.begin(); pattern_iter != expansion.end(); ++pattern_iter) {
+						config::dump_filter_matcher.add(*pattern_iter, config::dump_filter_opts.size());
+					}
+					config::dump_filter_opts.push_back(std::make_pair(expansion, tags));
+				}
+				catch (const std::logic_error& err) {
+					return false;
+				}
+			}
+		}
+	}
+
+	if (cfg.HasMember("shm-export")) {
+		config::shm_export_opts.configure(cfg["shm-export"]);
+	}
+
+	if (cfg.HasMember("push-export")) {
+		config::push_export_opts.configure(cfg["push-export"]);
+	}
+
+	if (cfg.HasMember("registry")) {
+		config::registry_opts.configure(cfg["registry"]);
+	}
 
 	if (cfg.HasMember("enable")) {
 		const rapidjson::Value& core_enable = cfg["enable"];
@@ -361,6 +449,7 @@ bool config_json(const char* config_data) {
 	 *
 	 * {
 	 *   "<pattern>": {
+	 *     "max-metrics": ...,
 	 *     ...
 	 *   }
 	 * }
@@ -383,6 +472,11 @@ bool config_json(const char* config_data) {
 				|| strcmp(member_name.GetString(), "counter") == 0
 				|| strcmp(member_name.GetString(), "timer") == 0
 				|| strcmp(member_name.GetString(), "dump-interval") == 0
+				|| strcmp(member_name.GetString(), "dump-formats") == 0
+				|| strcmp(member_name.GetString(), "dump-filter") == 0
+				|| strcmp(member_name.GetString(), "shm-export") == 0
+				|| strcmp(member_name.GetString(), "push-export") == 0
+				|| strcmp(member_name.GetString(), "registry") == 0
 				|| strcmp(member_name.GetString(), "enable") == 0
 		   )
 		{
@@ -393,7 +487,34 @@ bool config_json(const char* config_data) {
 		try {
 			std::vector<std::string> expansion = config::expand_pattern(member_name.GetString());
 
-			config::pattern_opts.push_back(std::make_pair(expansion, &member_value));
+			for (auto pattern_iter = expansion.begin(); pattern_iter != expansion.end(); ++pattern_iter) {
+				config::pattern_opts_matcher.add(*pattern_iter, config::pattern_opts.size());
+			}
+			// pattern options are based on default options configured above
+			config::pattern_options options;
+
+			options.gauge = config::metrics::gauge_opts;
+			options.gauge.configure(member_value);
+
+			options.counter = config::metrics::counter_opts;
+			options.counter.configure(member_value);
+
+			options.timer = config::metrics::timer_opts;
+			options.timer.configure(member_value);
+
+			if (member_value.IsObject() && member_value.HasMember("max-metrics")) {
+				const rapidjson::Value& max_metrics = member_value["max-metrics"];
+				if (max_metrics.IsUint64()) {
+					options.max_metrics = max_metrics.GetUint64();
+				}
+			}
+			const std::string overflow_prefix = std::string(member_name.GetString(), member_name.GetStringLength()) + ".__overflow__.";
+			options.overflow_names[events::event_destination_type::COUNTER] = overflow_prefix + "counter";
+			options.overflow_names[events::event_destination_type::GAUGE] = overflow_prefix + "gauge";
+			options.overflow_names[events::event_destination_type::TIMER] = overflow_prefix + "timer";
+			options.overflow_names[events::event_destination_type::ATTRIBUTE] = overflow_prefix + "attribute";
+
+			config::pattern_opts.push_back(std::make_pair(expansion, options));
 		}
 		catch (const std::logic_error& err) {
 			return false;
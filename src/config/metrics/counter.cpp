@@ -15,12 +15,15 @@
 * License along with this library.
 */
 
+#include <cstring>
+
 #include <handystats/config/metrics/counter.hpp>
 
 namespace handystats { namespace config { namespace metrics {
 
 counter::counter()
-	: values(statistics())
+	: coarse_timestamp(false)
+	, values(statistics())
 {
 }
 
@@ -29,6 +32,18 @@ void counter::configure(const rapidjson::Value& config) {
 		return;
 	}
 
+	if (config.HasMember("timestamp")) {
+		const rapidjson::Value& timestamp = config["timestamp"];
+		if (timestamp.IsString()) {
+			if (strcmp(timestamp.GetString(), "coarse") == 0) {
+				this->coarse_timestamp = true;
+			}
+			else if (strcmp(timestamp.GetString(), "precise") == 0) {
+				this->coarse_timestamp = false;
+			}
+		}
+	}
+
 	this->values.configure(config);
 }
 
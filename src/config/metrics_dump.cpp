@@ -15,12 +15,33 @@
  * License along with this library.
  */
 
+#include <cstring>
+
 #include "config/metrics_dump_impl.hpp"
 
 namespace handystats { namespace config {
 
+namespace dump_format {
+
+int from_string(const char* format_name) {
+	if (strcmp(format_name, "json") == 0) {
+		return JSON;
+	}
+	if (strcmp(format_name, "prometheus") == 0) {
+		return PROMETHEUS;
+	}
+	if (strcmp(format_name, "binary") == 0) {
+		return BINARY;
+	}
+
+	return EMPTY;
+}
+
+} // namespace dump_format
+
 metrics_dump::metrics_dump()
 	: interval(750, chrono::time_unit::MSEC)
+	, formats(dump_format::EMPTY)
 {}
 
 void metrics_dump::configure(const rapidjson::Value& config) {
@@ -34,6 +55,24 @@ void metrics_dump::configure(const rapidjson::Value& config) {
 			this->interval = chrono::duration(interval.GetUint64(), chrono::time_unit::MSEC);
 		}
 	}
+
+	if (config.HasMember("formats")) {
+		configure_formats(config["formats"]);
+	}
+}
+
+void metrics_dump::configure_formats(const rapidjson::Value& formats) {
+	if (!formats.IsArray()) {
+		return;
+	}
+
+	this->formats = dump_format::EMPTY;
+	for (size_t index = 0; index < formats.Size(); ++index) {
+		const rapidjson::Value& format = formats[index];
+		if (format.IsString()) {
+			this->formats |= dump_format::from_string(format.GetString());
+		}
+	}
 }
 
 }} // namespace handystats::config
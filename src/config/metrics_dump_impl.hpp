@@ -23,11 +23,30 @@
 
 namespace handystats { namespace config {
 
+namespace dump_format {
+
+enum : int {
+	EMPTY = 0,
+
+	JSON = 1 << 0,
+	PROMETHEUS = 1 << 1,
+	BINARY = 1 << 2,
+};
+
+// returns EMPTY for unknown format name
+int from_string(const char* format_name);
+
+} // namespace dump_format
+
 struct metrics_dump {
 	chrono::duration interval;
+	// bitmask of dump_format values rendered on each dump update,
+	// other formats are rendered on first request once per dump
+	int formats;
 
 	metrics_dump();
 	void configure(const rapidjson::Value& config);
+	void configure_formats(const rapidjson::Value& formats);
 };
 
 }} // namespace handystats::config
@@ -0,0 +1,496 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+#include <fnmatch.h>
+
+#include "config/pattern_matcher_impl.hpp"
+
+namespace handystats { namespace config {
+
+const size_t pattern_matcher::npos = std::numeric_limits<size_t>::max();
+const pattern_matcher::node_id pattern_matcher::NO_NODE = std::numeric_limits<node_id>::max();
+
+static const int32_t UNKNOWN_STATE = -1;
+// transition is not cached as MAX_DFA_STATES are built already
+static const int32_t FULL_STATE = -2;
+
+
+pattern_matcher::char_set::char_set() {
+	memset(bits, 0, sizeof(bits));
+}
+
+void pattern_matcher::char_set::set(const unsigned char& c) {
+	bits[c >> 6] |= uint64_t(1) << (c & 63);
+}
+
+bool pattern_matcher::char_set::test(const unsigned char& c) const {
+	return bits[c >> 6] & (uint64_t(1) << (c & 63));
+}
+
+void pattern_matcher::char_set::invert() {
+	for (size_t index = 0; index < 4; ++index) {
+		bits[index] = ~bits[index];
+	}
+}
+
+bool pattern_matcher::char_set::operator== (const char_set& other) const {
+	return memcmp(bits, other.bits, sizeof(bits)) == 0;
+}
+
+
+pattern_matcher::node::node()
+	: any(NO_NODE)
+	, star(NO_NODE)
+	, loop(false)
+	, accept(npos)
+{}
+
+
+pattern_matcher::dfa_state::dfa_state()
+	: nodes()
+	, accept(npos)
+{
+	reset();
+}
+
+void pattern_matcher::dfa_state::reset() {
+	nodes.clear();
+	for (size_t index = 0; index < 256; ++index) {
+		next[index].store(UNKNOWN_STATE, std::memory_order_relaxed);
+	}
+	accept = npos;
+}
+
+
+pattern_matcher::pattern_matcher()
+	: m_dfa_size(0)
+{
+	clear();
+}
+
+void pattern_matcher::clear() {
+	m_nodes.clear();
+	m_fallback.clear();
+	new_node();
+
+	reset_dfa();
+}
+
+bool pattern_matcher::empty() const {
+	return m_fallback.empty() && m_nodes.size() == 1 && m_nodes.front().accept == npos;
+}
+
+pattern_matcher::node_id pattern_matcher::new_node() {
+	m_nodes.push_back(node());
+	return m_nodes.size() - 1;
+}
+
+void pattern_matcher::add(const std::string& pattern, const size_t& index) {
+	if (compile(pattern, index) == UNSUPPORTED) {
+		m_fallback.push_back(std::make_pair(pattern, index));
+	}
+
+	reset_dfa();
+}
+
+static int match_class(const std::string& name, const unsigned char& c) {
+	if (name == "alnum") return isalnum(c);
+	if (name == "alpha") return isalpha(c);
+	if (name == "blank") return isblank(c);
+	if (name == "cntrl") return iscntrl(c);
+	if (name == "digit") return isdigit(c);
+	if (name == "graph") return isgraph(c);
+	if (name == "lower") return islower(c);
+	if (name == "print") return isprint(c);
+	if (name == "punct") return ispunct(c);
+	if (name == "space") return isspace(c);
+	if (name == "upper") return isupper(c);
+	if (name == "xdigit") return isxdigit(c);
+	return -1;
+}
+
+// pos points to '[', on success pos points past closing ']'
+pattern_matcher::parse_result
+pattern_matcher::parse_set(const std::string& pattern, size_t& pos, char_set& set) {
+	size_t cur = pos + 1;
+	bool negate = false;
+
+	if (cur < pattern.size() && (pattern[cur] == '!' || pattern[cur] == '^')) {
+		negate = true;
+		++cur;
+	}
+
+	bool first = true;
+	while (true) {
+		if (cur >= pattern.size()) {
+			// unterminated bracket expression, '[' is matched literally
+			return LITERAL;
+		}
+
+		unsigned char c = pattern[cur];
+
+		if (c == ']' && !first) {
+			++cur;
+			break;
+		}
+		first = false;
+
+		if (c == '[' && cur + 1 < pattern.size() && pattern[cur + 1] == ':') {
+			const size_t class_end = pattern.find(":]", cur + 2);
+			if (class_end == std::string::npos) {
+				return UNSUPPORTED;
+			}
+
+			const std::string class_name = pattern.substr(cur + 2, class_end - cur - 2);
+			if (match_class(class_name, 'a') < 0) {
+				return UNSUPPORTED;
+			}
+
+			for (int ch = 0; ch < 256; ++ch) {
+				if (match_class(class_name, ch)) {
+					set.set(ch);
+				}
+			}
+
+			cur = class_end + 2;
+			continue;
+		}
+
+		if (c == '[' && cur + 1 < pattern.size() && (pattern[cur + 1] == '=' || pattern[cur + 1] == '.')) {
+			return UNSUPPORTED;
+		}
+
+		if (c == '\\') {
+			if (cur + 1 >= pattern.size()) {
+				return UNSUPPORTED;
+			}
+			c = pattern[++cur];
+		}
+		++cur;
+
+		// range
+		if (cur + 1 < pattern.size() && pattern[cur] == '-' && pattern[cur + 1] != ']') {
+			size_t range_end_pos = cur + 1;
+			if (pattern[range_end_pos] == '[') {
+				return UNSUPPORTED;
+			}
+			if (pattern[range_end_pos] == '\\') {
+				if (range_end_pos + 1 >= pattern.size()) {
+					return UNSUPPORTED;
+				}
+				++range_end_pos;
+			}
+
+			const unsigned char range_end = pattern[range_end_pos];
+			for (int ch = c; ch <= range_end; ++ch) {
+				set.set(ch);
+			}
+
+			cur = range_end_pos + 1;
+			continue;
+		}
+
+		set.set(c);
+	}
+
+	if (negate) {
+		set.invert();
+	}
+
+	pos = cur;
+	return PARSED;
+}
+
+pattern_matcher::parse_result
+pattern_matcher::compile(const std::string& pattern, const size_t& index) {
+	// validate pattern first, trie should not be left with partial paths
+	std::vector<std::pair<int, char_set>> tokens;
+	enum { LITERAL_TOKEN, ANY_TOKEN, STAR_TOKEN, SET_TOKEN };
+
+	size_t pos = 0;
+	while (pos < pattern.size()) {
+		const unsigned char c = pattern[pos];
+		char_set set;
+
+		if (c == '*') {
+			if (tokens.empty() || tokens.back().first != STAR_TOKEN) {
+				tokens.push_back(std::make_pair(int(STAR_TOKEN), set));
+			}
+			++pos;
+		}
+		else if (c == '?') {
+			tokens.push_back(std::make_pair(int(ANY_TOKEN), set));
+			++pos;
+		}
+		else if (c == '[') {
+			const parse_result res = parse_set(pattern, pos, set);
+			if (res == UNSUPPORTED) {
+				return UNSUPPORTED;
+			}
+			if (res == LITERAL) {
+				set.set(c);
+				++pos;
+				tokens.push_back(std::make_pair(int(LITERAL_TOKEN), set));
+			}
+			else {
+				tokens.push_back(std::make_pair(int(SET_TOKEN), set));
+			}
+		}
+		else if (c == '\\') {
+			if (pos + 1 >= pattern.size()) {
+				return UNSUPPORTED;
+			}
+			set.set(pattern[pos + 1]);
+			tokens.push_back(std::make_pair(int(LITERAL_TOKEN), set));
+			pos += 2;
+		}
+		else {
+			set.set(c);
+			tokens.push_back(std::make_pair(int(LITERAL_TOKEN), set));
+			++pos;
+		}
+	}
+
+	node_id current = 0;
+	for (auto token_iter = tokens.begin(); token_iter != tokens.end(); ++token_iter) {
+		node_id next = NO_NODE;
+
+		switch (token_iter->first) {
+			case STAR_TOKEN:
+				next = m_nodes[current].star;
+				if (next == NO_NODE) {
+					next = new_node();
+					m_nodes[next].loop = true;
+					m_nodes[current].star = next;
+				}
+				break;
+			case ANY_TOKEN:
+				next = m_nodes[current].any;
+				if (next == NO_NODE) {
+					next = new_node();
+					m_nodes[current].any = next;
+				}
+				break;
+			case LITERAL_TOKEN:
+				{
+					unsigned char c = 0;
+					while (!token_iter->second.test(c)) {
+						++c;
+					}
+					auto literal_iter = m_nodes[current].literals.find(c);
+					if (literal_iter != m_nodes[current].literals.end()) {
+						next = literal_iter->second;
+					}
+					else {
+						next = new_node();
+						m_nodes[current].literals[c] = next;
+					}
+				}
+				break;
+			case SET_TOKEN:
+				{
+					auto& sets = m_nodes[current].sets;
+					for (auto set_iter = sets.begin(); set_iter != sets.end(); ++set_iter) {
+						if (set_iter->first == token_iter->second) {
+							next = set_iter->second;
+							break;
+						}
+					}
+					if (next == NO_NODE) {
+						next = new_node();
+						m_nodes[current].sets.push_back(std::make_pair(token_iter->second, next));
+					}
+				}
+				break;
+		}
+
+		current = next;
+	}
+
+	m_nodes[current].accept = std::min(m_nodes[current].accept, index);
+
+	return PARSED;
+}
+
+void pattern_matcher::closure(const node_id& id, std::vector<node_id>& nodes) const {
+	nodes.push_back(id);
+	// '*' may match empty sequence
+	if (m_nodes[id].star != NO_NODE) {
+		nodes.push_back(m_nodes[id].star);
+	}
+}
+
+void pattern_matcher::step(const std::vector<node_id>& nodes, const unsigned char& c, std::vector<node_id>& next_nodes) const {
+	for (auto node_iter = nodes.begin(); node_iter != nodes.end(); ++node_iter) {
+		const node& current = m_nodes[*node_iter];
+
+		if (current.loop) {
+			closure(*node_iter, next_nodes);
+		}
+		if (current.any != NO_NODE) {
+			closure(current.any, next_nodes);
+		}
+
+		auto literal_iter = current.literals.find(c);
+		if (literal_iter != current.literals.end()) {
+			closure(literal_iter->second, next_nodes);
+		}
+
+		for (auto set_iter = current.sets.begin(); set_iter != current.sets.end(); ++set_iter) {
+			if (set_iter->first.test(c)) {
+				closure(set_iter->second, next_nodes);
+			}
+		}
+	}
+
+	std::sort(next_nodes.begin(), next_nodes.end());
+	next_nodes.erase(std::unique(next_nodes.begin(), next_nodes.end()), next_nodes.end());
+}
+
+// matches rest of the name starting from set of NFA nodes without DFA caching
+size_t pattern_matcher::simulate(std::vector<node_id> nodes, const std::string& name, size_t pos) const {
+	std::vector<node_id> next_nodes;
+	for (; pos < name.size() && !nodes.empty(); ++pos) {
+		next_nodes.clear();
+		step(nodes, name[pos], next_nodes);
+		nodes.swap(next_nodes);
+	}
+
+	size_t accept = npos;
+	for (auto node_iter = nodes.begin(); node_iter != nodes.end(); ++node_iter) {
+		accept = std::min(accept, m_nodes[*node_iter].accept);
+	}
+	return accept;
+}
+
+pattern_matcher::dfa_state& pattern_matcher::dfa(const int32_t& id) const {
+	return m_dfa_chunks[id / DFA_CHUNK_STATES][id % DFA_CHUNK_STATES];
+}
+
+// drops cached DFA, should not be called concurrently with match()
+void pattern_matcher::reset_dfa() {
+	std::lock_guard<std::mutex> lock(m_dfa_mutex);
+
+	for (size_t id = 0; id < m_dfa_size; ++id) {
+		dfa(id).reset();
+	}
+	m_dfa_size = 0;
+	m_dfa_index.clear();
+
+	// state 0 is start state
+	std::vector<node_id> start_nodes;
+	closure(0, start_nodes);
+	dfa_state_for(start_nodes);
+}
+
+// called under m_dfa_mutex
+int32_t pattern_matcher::dfa_state_for(std::vector<node_id>& nodes) const {
+	std::sort(nodes.begin(), nodes.end());
+	nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+	auto index_iter = m_dfa_index.find(nodes);
+	if (index_iter != m_dfa_index.end()) {
+		return index_iter->second;
+	}
+
+	if (m_dfa_size == MAX_DFA_STATES) {
+		return FULL_STATE;
+	}
+
+	const int32_t id = m_dfa_size;
+	std::unique_ptr<dfa_state[]>& chunk = m_dfa_chunks[id / DFA_CHUNK_STATES];
+	if (!chunk) {
+		chunk.reset(new dfa_state[DFA_CHUNK_STATES]);
+	}
+
+	dfa_state& state = dfa(id);
+	state.nodes = nodes;
+	for (auto node_iter = nodes.begin(); node_iter != nodes.end(); ++node_iter) {
+		state.accept = std::min(state.accept, m_nodes[*node_iter].accept);
+	}
+
+	++m_dfa_size;
+	m_dfa_index.insert(std::make_pair(nodes, id));
+	return id;
+}
+
+// builds missing transition, returns FULL_STATE if no more states could be cached
+int32_t pattern_matcher::dfa_next(const int32_t& state, const unsigned char& c) const {
+	std::lock_guard<std::mutex> lock(m_dfa_mutex);
+
+	int32_t next = dfa(state).next[c].load(std::memory_order_relaxed);
+	if (next != UNKNOWN_STATE) {
+		return next;
+	}
+
+	std::vector<node_id> next_nodes;
+	step(dfa(state).nodes, c, next_nodes);
+
+	next = dfa_state_for(next_nodes);
+	if (next != FULL_STATE) {
+		// new state is complete before its id is visible to lock-free readers
+		dfa(state).next[c].store(next, std::memory_order_release);
+	}
+	return next;
+}
+
+size_t pattern_matcher::match(const std::string& name) const {
+	if (empty()) {
+		return npos;
+	}
+
+	// cached transitions are followed without locking
+	int32_t state = 0;
+	size_t pos = 0;
+	while (pos < name.size() && !dfa(state).nodes.empty()) {
+		const unsigned char c = name[pos];
+
+		int32_t next = dfa(state).next[c].load(std::memory_order_acquire);
+		if (next == UNKNOWN_STATE) {
+			next = dfa_next(state, c);
+		}
+		if (next == FULL_STATE) {
+			break;
+		}
+
+		state = next;
+		++pos;
+	}
+
+	size_t result = npos;
+	if (pos < name.size() && !dfa(state).nodes.empty()) {
+		result = simulate(dfa(state).nodes, name, pos);
+	}
+	else {
+		result = dfa(state).accept;
+	}
+
+	for (auto fallback_iter = m_fallback.begin(); fallback_iter != m_fallback.end(); ++fallback_iter) {
+		if (fallback_iter->second < result && fnmatch(fallback_iter->first.c_str(), name.c_str(), 0) == 0) {
+			result = fallback_iter->second;
+		}
+	}
+
+	return result;
+}
+
+}} // namespace handystats::config
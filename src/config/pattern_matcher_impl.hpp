@@ -0,0 +1,131 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_CONFIG_PATTERN_MATCHER_IMPL_HPP_
+#define HANDYSTATS_CONFIG_PATTERN_MATCHER_IMPL_HPP_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <handystats/atomic.hpp>
+
+namespace handystats { namespace config {
+
+/*
+ * Set of fnmatch(3)-style glob patterns (flags = 0) compiled into single automaton.
+ *
+ * Patterns are merged into a trie-shaped NFA, which is lazily converted into DFA
+ * while matching, so match time is linear in the name length and does not depend
+ * on the number of patterns once DFA states are cached.
+ * Cached transitions are read without locking, only missing transitions are built under mutex.
+ * Once MAX_DFA_STATES are cached the rest of name is matched by NFA simulation without caching.
+ * Patterns with constructs not supported by the automaton ([=...=], [.....], trailing '\')
+ * are matched with fnmatch(3).
+ *
+ * Each pattern is added with an index, match() returns the smallest index of matching patterns.
+ */
+class pattern_matcher {
+public:
+	static const size_t npos;
+
+	pattern_matcher();
+
+	void add(const std::string& pattern, const size_t& index);
+	void clear();
+
+	size_t match(const std::string& name) const;
+
+	bool empty() const;
+
+private:
+	typedef uint32_t node_id;
+	static const node_id NO_NODE;
+
+	struct char_set {
+		uint64_t bits[4];
+
+		char_set();
+		void set(const unsigned char& c);
+		bool test(const unsigned char& c) const;
+		void invert();
+		bool operator== (const char_set& other) const;
+	};
+
+	struct node {
+		std::map<unsigned char, node_id> literals;
+		std::vector<std::pair<char_set, node_id>> sets;
+		node_id any;
+		// node of '*' following this node
+		node_id star;
+		// node itself is '*', consumes any character
+		bool loop;
+		size_t accept;
+
+		node();
+	};
+
+	// state is immutable once its id is published in transition table, except for the table itself
+	struct dfa_state {
+		std::vector<node_id> nodes;
+		std::atomic<int32_t> next[256];
+		size_t accept;
+
+		dfa_state();
+		void reset();
+	};
+
+	static const size_t MAX_DFA_STATES = 1024;
+	// states are allocated in chunks that are never moved
+	static const size_t DFA_CHUNK_STATES = 64;
+
+	enum parse_result {
+		PARSED,
+		LITERAL,
+		UNSUPPORTED
+	};
+
+	node_id new_node();
+	parse_result compile(const std::string& pattern, const size_t& index);
+	static parse_result parse_set(const std::string& pattern, size_t& pos, char_set& set);
+
+	void closure(const node_id& id, std::vector<node_id>& nodes) const;
+	void step(const std::vector<node_id>& nodes, const unsigned char& c, std::vector<node_id>& next_nodes) const;
+	size_t simulate(std::vector<node_id> nodes, const std::string& name, size_t pos) const;
+
+	dfa_state& dfa(const int32_t& id) const;
+	void reset_dfa();
+	int32_t dfa_state_for(std::vector<node_id>& nodes) const;
+	int32_t dfa_next(const int32_t& state, const unsigned char& c) const;
+
+	std::vector<node> m_nodes;
+	std::vector<std::pair<std::string, size_t>> m_fallback;
+
+	// lazily built DFA, new states and transitions are added under m_dfa_mutex
+	mutable std::mutex m_dfa_mutex;
+	mutable std::unique_ptr<dfa_state[]> m_dfa_chunks[MAX_DFA_STATES / DFA_CHUNK_STATES];
+	mutable size_t m_dfa_size;
+	mutable std::map<std::vector<node_id>, int32_t> m_dfa_index;
+};
+
+}} // namespace handystats::config
+
+#endif // HANDYSTATS_CONFIG_PATTERN_MATCHER_IMPL_HPP_
@@ -0,0 +1,60 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include "config/push_export_impl.hpp"
+
+namespace handystats { namespace config {
+
+push_export::push_export()
+	: address()
+	, buffer_size(1 << 20)
+	, max_datagram_size(1432)
+{}
+
+void push_export::configure(const rapidjson::Value& config) {
+	if (config.IsString()) {
+		this->address = std::string(config.GetString(), config.GetStringLength());
+		return;
+	}
+
+	if (!config.IsObject()) {
+		return;
+	}
+
+	if (config.HasMember("address")) {
+		const rapidjson::Value& address = config["address"];
+		if (address.IsString()) {
+			this->address = std::string(address.GetString(), address.GetStringLength());
+		}
+	}
+
+	if (config.HasMember("buffer-size")) {
+		const rapidjson::Value& buffer_size = config["buffer-size"];
+		if (buffer_size.IsUint64() && buffer_size.GetUint64() > 0) {
+			this->buffer_size = buffer_size.GetUint64();
+		}
+	}
+
+	if (config.HasMember("max-datagram-size")) {
+		const rapidjson::Value& max_datagram_size = config["max-datagram-size"];
+		if (max_datagram_size.IsUint64() && max_datagram_size.GetUint64() > 0) {
+			this->max_datagram_size = max_datagram_size.GetUint64();
+		}
+	}
+}
+
+}} // namespace handystats::config
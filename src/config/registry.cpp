@@ -0,0 +1,47 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include "config/registry_impl.hpp"
+
+namespace handystats { namespace config {
+
+registry::registry()
+	: ttl()
+	, max_size(0)
+{}
+
+void registry::configure(const rapidjson::Value& config) {
+	if (!config.IsObject()) {
+		return;
+	}
+
+	if (config.HasMember("ttl")) {
+		const rapidjson::Value& ttl = config["ttl"];
+		if (ttl.IsUint64()) {
+			this->ttl = chrono::duration(ttl.GetUint64(), chrono::time_unit::MSEC);
+		}
+	}
+
+	if (config.HasMember("max-size")) {
+		const rapidjson::Value& max_size = config["max-size"];
+		if (max_size.IsUint64()) {
+			this->max_size = max_size.GetUint64();
+		}
+	}
+}
+
+}} // namespace handystats::config
@@ -0,0 +1,42 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_CONFIG_REGISTRY_IMPL_HPP_
+#define HANDYSTATS_CONFIG_REGISTRY_IMPL_HPP_
+
+#include <cstddef>
+
+#include <handystats/chrono.hpp>
+#include <handystats/rapidjson/document.h>
+
+namespace handystats { namespace config {
+
+struct registry {
+	// metrics without events for longer than ttl are evicted (except timers with running instances),
+	// eviction by idle time is disabled if zero
+	chrono::duration ttl;
+	// max number of metrics, least recently updated metrics are evicted above it on insertion and dump,
+	// unlimited if zero
+	size_t max_size;
+
+	registry();
+	void configure(const rapidjson::Value& config);
+};
+
+}} // namespace handystats::config
+
+#endif // HANDYSTATS_CONFIG_REGISTRY_IMPL_HPP_
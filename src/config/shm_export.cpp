@@ -0,0 +1,52 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include "config/shm_export_impl.hpp"
+
+namespace handystats { namespace config {
+
+shm_export::shm_export()
+	: name()
+	, size(1 << 20)
+{}
+
+void shm_export::configure(const rapidjson::Value& config) {
+	if (config.IsString()) {
+		this->name = std::string(config.GetString(), config.GetStringLength());
+		return;
+	}
+
+	if (!config.IsObject()) {
+		return;
+	}
+
+	if (config.HasMember("name")) {
+		const rapidjson::Value& name = config["name"];
+		if (name.IsString()) {
+			this->name = std::string(name.GetString(), name.GetStringLength());
+		}
+	}
+
+	if (config.HasMember("size")) {
+		const rapidjson::Value& size = config["size"];
+		if (size.IsUint64() && size.GetUint64() > 0) {
+			this->size = size.GetUint64();
+		}
+	}
+}
+
+}} // namespace handystats::config
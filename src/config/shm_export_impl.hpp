@@ -0,0 +1,40 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_CONFIG_SHM_EXPORT_IMPL_HPP_
+#define HANDYSTATS_CONFIG_SHM_EXPORT_IMPL_HPP_
+
+#include <string>
+#include <cstddef>
+
+#include <handystats/rapidjson/document.h>
+
+namespace handystats { namespace config {
+
+struct shm_export {
+	// shared memory object name ("%p" is replaced with pid), export is disabled if empty
+	std::string name;
+	// initial size of payload area in bytes, grows if dump does not fit
+	size_t size;
+
+	shm_export();
+	void configure(const rapidjson::Value& config);
+};
+
+}} // namespace handystats::config
+
+#endif // HANDYSTATS_CONFIG_SHM_EXPORT_IMPL_HPP_
@@ -19,8 +19,10 @@
 #define HANDYSTATS_CONFIG_IMPL_HPP_
 
 #include <memory>
+#include <string>
 #include <vector>
 
+#include <handystats/statistics.hpp>
 #include <handystats/config/statistics.hpp>
 #include <handystats/config/metrics/gauge.hpp>
 #include <handystats/config/metrics/counter.hpp>
@@ -28,6 +30,10 @@
 
 #include "config/metrics_dump_impl.hpp"
 #include "config/core_impl.hpp"
+#include "config/shm_export_impl.hpp"
+#include "config/push_export_impl.hpp"
+#include "config/registry_impl.hpp"
+#include "config/pattern_matcher_impl.hpp"
 
 namespace handystats { namespace config {
 
@@ -41,20 +47,58 @@ namespace metrics {
 
 extern metrics_dump metrics_dump_opts;
 extern core core_opts;
+extern shm_export shm_export_opts;
+extern push_export push_export_opts;
+extern registry registry_opts;
+
+// metrics options for pattern, parsed once at configuration time
+struct pattern_options {
+	metrics::gauge gauge;
+	metrics::counter counter;
+	metrics::timer timer;
+
+	// max number of metrics matching pattern, unlimited if zero
+	size_t max_metrics;
+	// events of new metrics above max_metrics are folded into overflow metric of event's type
+	// ("<pattern>.__overflow__.counter", ".gauge", ".timer", ".attribute"), indexed by destination type
+	std::string overflow_names[4];
+
+	pattern_options()
+		: gauge(), counter(), timer()
+		, max_metrics(0)
+	{}
+};
 
 extern
 std::vector<
 	std::pair<
 		std::vector<std::string>,
-		rapidjson::Value*
+		pattern_options
 	>
 >
 pattern_opts;
 
+// dump-filter patterns with statistics tags to be serialized
+extern
+std::vector<
+	std::pair<
+		std::vector<std::string>,
+		handystats::statistics::tag::type
+	>
+>
+dump_filter_opts;
+
+extern pattern_matcher pattern_opts_matcher;
+extern pattern_matcher dump_filter_matcher;
+
 extern
 std::shared_ptr<rapidjson::Document> source;
 
-rapidjson::Value* select_pattern(const std::string&);
+// returns options of first pattern group matching metric name or nullptr
+const pattern_options* select_pattern(const std::string&);
+
+// returns statistics tags allowed to be dumped for metric name (all tags if no dump-filter pattern matches)
+handystats::statistics::tag::type select_dump_tags(const std::string&);
 
 void initialize();
 void finalize();
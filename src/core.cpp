@@ -24,39 +24,42 @@
 #include <handystats/chrono.hpp>
 #include <handystats/core.hpp>
 #include <handystats/core.h>
+#include <handystats/measuring_points/clock.hpp>
 
 #include "events/event_message_impl.hpp"
 #include "message_queue_impl.hpp"
 #include "internal_impl.hpp"
 #include "metrics_dump_impl.hpp"
+#include "shm_export_impl.hpp"
+#include "push_export_impl.hpp"
 #include "config_impl.hpp"
+#include "chrono_impl.hpp"
 
 #include "core_impl.hpp"
 
 namespace handystats {
 
 std::mutex operation_mutex;
-std::atomic<bool> enabled_flag(false);
-
-bool is_enabled() {
-	return config::core_opts.enable && enabled_flag.load(std::memory_order_acquire);
-}
+// set only if core is enabled in configuration
+enabled_flag_type enabled_flag(false);
 
 
 chrono::time_point last_message_timestamp;
 std::thread processor_thread;
 
-static void process_message_queue() {
+static bool process_message_queue() {
 	auto* message = message_queue::pop();
 
-	chrono::time_point timestamp;
-
-	if (message) {
-		last_message_timestamp = std::max(last_message_timestamp, message->timestamp);
-		internal::process_event_message(*message);
+	if (!message) {
+		return false;
 	}
 
+	last_message_timestamp = std::max(last_message_timestamp, message->timestamp);
+	internal::process_event_message(*message);
+
 	events::delete_event_message(message);
+
+	return true;
 }
 
 static void run_processor() {
@@ -68,14 +71,13 @@ static void run_processor() {
 	prctl(PR_SET_NAME, thread_name);
 
 	while (is_enabled()) {
-		if (!message_queue::empty()) {
-			process_message_queue();
-		}
-		else {
+		if (!process_message_queue()) {
 			last_message_timestamp = std::max(last_message_timestamp, chrono::tsc_clock::now());
 			std::this_thread::sleep_for(std::chrono::microseconds(10));
 		}
 
+		chrono::refine_cycles_per_nanosec();
+
 		metrics_dump::update(chrono::tsc_clock::now(), last_message_timestamp);
 	}
 }
@@ -86,7 +88,9 @@ void initialize() {
 		return;
 	}
 
+	chrono::stats::initialize();
 	metrics_dump::initialize();
+	shm_export::initialize();
 	internal::initialize();
 	message_queue::initialize();
 
@@ -94,6 +98,15 @@ void initialize() {
 		return;
 	}
 
+	push_export::initialize();
+
+	measuring_points::counter_coarse_timestamp.store(config::metrics::counter_opts.coarse_timestamp, std::memory_order_relaxed);
+	measuring_points::gauge_coarse_timestamp.store(config::metrics::gauge_opts.coarse_timestamp, std::memory_order_relaxed);
+
+	if (config::metrics::counter_opts.coarse_timestamp || config::metrics::gauge_opts.coarse_timestamp) {
+		chrono::start_coarse_clock();
+	}
+
 	enabled_flag.store(true, std::memory_order_release);
 
 	last_message_timestamp = chrono::time_point();
@@ -109,9 +122,18 @@ void finalize() {
 		processor_thread.join();
 	}
 
+	measuring_points::counter_coarse_timestamp.store(false, std::memory_order_relaxed);
+	measuring_points::gauge_coarse_timestamp.store(false, std::memory_order_relaxed);
+
+	chrono::stop_coarse_clock();
+
+	push_export::finalize();
+
 	internal::finalize();
 	message_queue::finalize();
 	metrics_dump::finalize();
+	shm_export::finalize();
+	chrono::stats::finalize();
 	config::finalize();
 }
 
@@ -20,12 +20,12 @@
 
 #include <mutex>
 
+#include <handystats/core.hpp>
+
 namespace handystats {
 
 extern std::mutex operation_mutex;
 
-bool is_enabled();
-
 } // namespace handystats
 
 
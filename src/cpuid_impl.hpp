@@ -59,6 +59,22 @@ bool rdtscp_supported() {
 	return ((edx >> 27) & 1);
 }
 
+// TSC frequency in Hz (15H EBX/EAX * ECX, or 16H EAX base frequency in MHz), 0 if not enumerated
+static
+uint64_t tsc_frequency() {
+	uint32_t eax, ebx, ecx, edx;
+
+	if (__get_cpuid(0x15, &eax, &ebx, &ecx, &edx) && eax != 0 && ebx != 0 && ecx != 0) {
+		return (uint64_t)ecx * ebx / eax;
+	}
+
+	if (__get_cpuid(0x16, &eax, &ebx, &ecx, &edx) && eax != 0) {
+		return (uint64_t)(eax & 0xffff) * 1000000;
+	}
+
+	return 0;
+}
+
 } // namespace handystats
 
 #endif // HANDYSTATS_CPUID_IMPL_HPP_
@@ -0,0 +1,103 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_DUMP_FILTER_IMPL_HPP_
+#define HANDYSTATS_DUMP_FILTER_IMPL_HPP_
+
+#include <string>
+#include <memory>
+#include <map>
+#include <unordered_map>
+
+#include <handystats/statistics.hpp>
+#include <handystats/metrics.hpp>
+
+namespace handystats { namespace metrics_dump {
+
+/*
+ * Statistics tags selected by "dump-filter" configuration option for metrics of single dump.
+ *
+ * Filter is snapshotted by processing thread on dump creation and is immutable afterwards,
+ * so dump could be rendered from any thread without reading configuration.
+ * Metrics not listed in the filter are serialized with all enabled statistics.
+ */
+class tags_filter {
+public:
+	typedef std::unordered_map<std::string, statistics::tag::type> tags_map;
+
+	// passes all tags
+	tags_filter()
+		: m_tags()
+	{}
+
+	explicit tags_filter(const std::shared_ptr<const tags_map>& tags)
+		: m_tags(tags)
+	{}
+
+	statistics::tag::type operator() (const std::string& name) const {
+		if (!m_tags) {
+			return ~statistics::tag::empty;
+		}
+
+		auto tags_iter = m_tags->find(name);
+		if (tags_iter == m_tags->end()) {
+			return ~statistics::tag::empty;
+		}
+
+		return tags_iter->second;
+	}
+
+private:
+	std::shared_ptr<const tags_map> m_tags;
+};
+
+// matches dump's metrics against current "dump-filter" configuration, called by processing thread
+tags_filter snapshot_tags_filter(const std::map<std::string, metrics::metric_variant>& dump);
+
+}} // namespace handystats::metrics_dump
+
+
+// Serialization of dump with statistics selected by filter, public overloads write all enabled statistics
+
+namespace handystats { namespace json {
+
+void write_to_string(
+		const std::map<std::string, handystats::metrics::metric_variant>&, std::string& buffer,
+		const bool& pretty, const metrics_dump::tags_filter&
+	);
+
+}} // namespace handystats::json
+
+namespace handystats { namespace prometheus {
+
+void write_to_string(
+		const std::map<std::string, handystats::metrics::metric_variant>&, std::string& buffer,
+		const metrics_dump::tags_filter&
+	);
+
+}} // namespace handystats::prometheus
+
+namespace handystats { namespace binary {
+
+void write_to_string(
+		const std::map<std::string, handystats::metrics::metric_variant>&, std::string& buffer,
+		const metrics_dump::tags_filter&
+	);
+
+}} // namespace handystats::binary
+
+#endif // HANDYSTATS_DUMP_FILTER_IMPL_HPP_
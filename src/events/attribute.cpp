@@ -15,6 +15,8 @@
 * License along with this library.
 */
 
+#include <new>
+#include <cstring>
 #include <algorithm>
 
 #include "events/attribute_impl.hpp"
@@ -22,12 +24,112 @@
 
 namespace handystats { namespace events { namespace attribute {
 
+template <typename Value>
+static event_message* create_inline_set_event(
+		std::string&& attribute_name,
+		const char& type,
+		const Value& value,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	static_assert(sizeof(Value) <= sizeof(event_message::event_data), "Value should fit in event_data");
+
+	event_message* message = new event_message;
+
+	message->destination_name.swap(attribute_name);
+	message->destination_type = event_destination_type::ATTRIBUTE;
+
+	message->timestamp = timestamp;
+
+	message->event_type = type;
+	new (&message->event_data) Value(value);
+
+	return message;
+}
+
+event_message* create_set_event(std::string&& attribute_name, const bool& b, const metrics::attribute::time_point& timestamp) {
+	return create_inline_set_event(std::move(attribute_name), event_type::SET_BOOL, b, timestamp);
+}
+
+event_message* create_set_event(std::string&& attribute_name, const int& i, const metrics::attribute::time_point& timestamp) {
+	return create_inline_set_event(std::move(attribute_name), event_type::SET_INT, i, timestamp);
+}
+
+event_message* create_set_event(std::string&& attribute_name, const unsigned& u, const metrics::attribute::time_point& timestamp) {
+	return create_inline_set_event(std::move(attribute_name), event_type::SET_UINT, u, timestamp);
+}
+
+event_message* create_set_event(std::string&& attribute_name, const int64_t& i64, const metrics::attribute::time_point& timestamp) {
+	return create_inline_set_event(std::move(attribute_name), event_type::SET_INT64, i64, timestamp);
+}
+
+event_message* create_set_event(std::string&& attribute_name, const uint64_t& u64, const metrics::attribute::time_point& timestamp) {
+	return create_inline_set_event(std::move(attribute_name), event_type::SET_UINT64, u64, timestamp);
+}
+
+event_message* create_set_event(std::string&& attribute_name, const double& d, const metrics::attribute::time_point& timestamp) {
+	return create_inline_set_event(std::move(attribute_name), event_type::SET_DOUBLE, d, timestamp);
+}
+
+// inline string is placed right after event message
+static const char* inline_string(const event_message& message) {
+	return reinterpret_cast<const char*>(&message + 1);
+}
+
+event_message* create_set_event(
+		std::string&& attribute_name,
+		const char* data, const size_t& size,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	if (size > MAX_INLINE_STRING_SIZE) {
+		return create_set_event(std::move(attribute_name), metrics::attribute::value_type(std::string(data, size)), timestamp);
+	}
+
+	event_message* message = new (::operator new(sizeof(event_message) + size)) event_message;
+	memcpy(const_cast<char*>(inline_string(*message)), data, size);
+
+	message->destination_name.swap(attribute_name);
+	message->destination_type = event_destination_type::ATTRIBUTE;
+
+	message->timestamp = timestamp;
+
+	message->event_type = event_type::SET_STRING;
+	new (&message->event_data) size_t(size);
+
+	return message;
+}
+
 event_message* create_set_event(
 		std::string&& attribute_name,
 		const metrics::attribute::value_type& value,
 		const metrics::attribute::time_point& timestamp
 	)
 {
+	switch (value.which()) {
+		case metrics::attribute::BOOL:
+			return create_set_event(std::move(attribute_name), boost::get<bool>(value), timestamp);
+		case metrics::attribute::INT:
+			return create_set_event(std::move(attribute_name), boost::get<int>(value), timestamp);
+		case metrics::attribute::UINT:
+			return create_set_event(std::move(attribute_name), boost::get<unsigned>(value), timestamp);
+		case metrics::attribute::INT64:
+			return create_set_event(std::move(attribute_name), boost::get<int64_t>(value), timestamp);
+		case metrics::attribute::UINT64:
+			return create_set_event(std::move(attribute_name), boost::get<uint64_t>(value), timestamp);
+		case metrics::attribute::DOUBLE:
+			return create_set_event(std::move(attribute_name), boost::get<double>(value), timestamp);
+		case metrics::attribute::STRING:
+			{
+				const std::string& str = boost::get<std::string>(value);
+				if (str.size() <= MAX_INLINE_STRING_SIZE) {
+					return create_set_event(std::move(attribute_name), str.data(), str.size(), timestamp);
+				}
+				break;
+			}
+	}
+
+	// out-of-line value
 	event_message* message = new event_message;
 
 	message->destination_name.swap(attribute_name);
@@ -41,29 +143,74 @@ event_message* create_set_event(
 	return message;
 }
 
-void delete_set_event(event_message* message) {
-	delete static_cast<metrics::attribute::value_type*>(message->event_data);
-
-	delete message;
-}
-
 void delete_event(event_message* message) {
 	switch (message->event_type) {
 		case event_type::SET:
-			delete_set_event(message);
+			delete static_cast<metrics::attribute::value_type*>(message->event_data);
+			delete message;
+			break;
+		case event_type::SET_STRING:
+			message->~event_message();
+			::operator delete(message);
+			break;
+		default:
+			delete message;
 			break;
 	}
 }
 
-void process_set_event(metrics::attribute& attribute, const event_message& message) {
-	const auto& value = *reinterpret_cast<metrics::attribute::value_type*>(message.event_data);
-	attribute.set(value);
+template <typename Value>
+static const Value& inline_value(const event_message& message) {
+	return *reinterpret_cast<const Value*>(&message.event_data);
+}
+
+metrics::attribute::value_type event_value(const event_message& message) {
+	switch (message.event_type) {
+		case event_type::SET_BOOL:
+			return inline_value<bool>(message);
+		case event_type::SET_INT:
+			return inline_value<int>(message);
+		case event_type::SET_UINT:
+			return inline_value<unsigned>(message);
+		case event_type::SET_INT64:
+			return inline_value<int64_t>(message);
+		case event_type::SET_UINT64:
+			return inline_value<uint64_t>(message);
+		case event_type::SET_DOUBLE:
+			return inline_value<double>(message);
+		case event_type::SET_STRING:
+			return std::string(inline_string(message), inline_value<size_t>(message));
+		case event_type::SET:
+		default:
+			return *reinterpret_cast<const metrics::attribute::value_type*>(message.event_data);
+	}
 }
 
 void process_event(metrics::attribute& attribute, const event_message& message) {
 	switch (message.event_type) {
 		case event_type::SET:
-			process_set_event(attribute, message);
+			attribute.set(*reinterpret_cast<const metrics::attribute::value_type*>(message.event_data));
+			break;
+		case event_type::SET_BOOL:
+			attribute.set(inline_value<bool>(message));
+			break;
+		case event_type::SET_INT:
+			attribute.set(inline_value<int>(message));
+			break;
+		case event_type::SET_UINT:
+			attribute.set(inline_value<unsigned>(message));
+			break;
+		case event_type::SET_INT64:
+			attribute.set(inline_value<int64_t>(message));
+			break;
+		case event_type::SET_UINT64:
+			attribute.set(inline_value<uint64_t>(message));
+			break;
+		case event_type::SET_DOUBLE:
+			attribute.set(inline_value<double>(message));
+			break;
+		case event_type::SET_STRING:
+			attribute.set(std::string(inline_string(message), inline_value<size_t>(message)));
 			break;
 		default:
 			return;
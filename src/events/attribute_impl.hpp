@@ -27,12 +27,26 @@
 
 namespace handystats { namespace events { namespace attribute {
 
+/*
+ * Values of scalar types are stored inline in event_data,
+ * strings up to MAX_INLINE_STRING_SIZE bytes are stored right after event message in the same allocation,
+ * longer strings are stored out-of-line (SET event).
+ */
 namespace event_type {
 enum : char {
-	SET = 0
+	SET = 0,
+	SET_BOOL,
+	SET_INT,
+	SET_UINT,
+	SET_INT64,
+	SET_UINT64,
+	SET_DOUBLE,
+	SET_STRING
 };
 } // namespace event_type
 
+const size_t MAX_INLINE_STRING_SIZE = 64;
+
 /*
  * Event creation functions
  */
@@ -42,6 +56,24 @@ event_message* create_set_event(
 		const metrics::attribute::time_point& timestamp
 	);
 
+event_message* create_set_event(std::string&& attribute_name, const bool& b, const metrics::attribute::time_point& timestamp);
+event_message* create_set_event(std::string&& attribute_name, const int& i, const metrics::attribute::time_point& timestamp);
+event_message* create_set_event(std::string&& attribute_name, const unsigned& u, const metrics::attribute::time_point& timestamp);
+event_message* create_set_event(std::string&& attribute_name, const int64_t& i64, const metrics::attribute::time_point& timestamp);
+event_message* create_set_event(std::string&& attribute_name, const uint64_t& u64, const metrics::attribute::time_point& timestamp);
+event_message* create_set_event(std::string&& attribute_name, const double& d, const metrics::attribute::time_point& timestamp);
+
+event_message* create_set_event(
+		std::string&& attribute_name,
+		const char* data, const size_t& size,
+		const metrics::attribute::time_point& timestamp
+	);
+
+/*
+ * Value carried by SET event of any kind
+ */
+metrics::attribute::value_type event_value(const event_message& message);
+
 /*
  * Event destructor
  */
@@ -0,0 +1,59 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include "events/batch_impl.hpp"
+
+
+namespace handystats { namespace events { namespace batch {
+
+event_message* create_submit_event(
+		event_message* first_message,
+		const chrono::time_point& timestamp
+	)
+{
+	event_message* message = new event_message;
+
+	message->destination_type = event_destination_type::BATCH;
+
+	message->timestamp = timestamp;
+
+	message->event_type = event_type::SUBMIT;
+	message->event_data = first_message;
+
+	return message;
+}
+
+const event_message* first_message(const event_message& message) {
+	return reinterpret_cast<const event_message*>(message.event_data);
+}
+
+const event_message* next_message(const event_message& batched_message) {
+	return batched_message.next.load(std::memory_order_relaxed);
+}
+
+void delete_event(event_message* message) {
+	event_message* batched_message = reinterpret_cast<event_message*>(message->event_data);
+	while (batched_message) {
+		event_message* next = batched_message->next.load(std::memory_order_relaxed);
+		delete_event_message(batched_message);
+		batched_message = next;
+	}
+
+	delete message;
+}
+
+}}} // namespace handystats::events::batch
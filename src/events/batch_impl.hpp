@@ -0,0 +1,60 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_BATCH_EVENT_IMPL_HPP_
+#define HANDYSTATS_BATCH_EVENT_IMPL_HPP_
+
+#include <handystats/chrono.hpp>
+
+#include "events/event_message_impl.hpp"
+
+
+namespace handystats { namespace events { namespace batch {
+
+namespace event_type {
+enum : char {
+	SUBMIT = 0
+};
+} // namespace event_type
+
+/*
+ * Event creation function
+ *
+ * Batched messages are chained through their (otherwise unused) queue node links,
+ * starting from the first message.
+ * Compound event takes ownership of the whole chain.
+ */
+event_message* create_submit_event(
+		event_message* first_message,
+		const chrono::time_point& timestamp
+	);
+
+/*
+ * Batched messages iteration
+ */
+const event_message* first_message(const event_message& message);
+const event_message* next_message(const event_message& batched_message);
+
+/*
+ * Event destructor
+ */
+void delete_event(event_message* message);
+
+}}} // namespace handystats::events::batch
+
+
+#endif // HANDYSTATS_BATCH_EVENT_IMPL_HPP_
@@ -19,6 +19,7 @@
 #include "events/counter_impl.hpp"
 #include "events/timer_impl.hpp"
 #include "events/attribute_impl.hpp"
+#include "events/batch_impl.hpp"
 
 #include "events/event_message_impl.hpp"
 
@@ -43,6 +44,9 @@ void delete_event_message(event_message* message) {
 		case event_destination_type::ATTRIBUTE:
 			attribute::delete_event(message);
 			break;
+		case event_destination_type::BATCH:
+			batch::delete_event(message);
+			break;
 		default:
 			return;
 	}
@@ -32,7 +32,8 @@ enum : char {
 	COUNTER = 0,
 	GAUGE,
 	TIMER,
-	ATTRIBUTE
+	ATTRIBUTE,
+	BATCH
 };
 }
 
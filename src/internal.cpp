@@ -17,6 +17,8 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <algorithm>
 
 #include <handystats/chrono.hpp>
 #include <handystats/metrics.hpp>
@@ -26,6 +28,7 @@
 #include "events/gauge_impl.hpp"
 #include "events/timer_impl.hpp"
 #include "events/attribute_impl.hpp"
+#include "events/batch_impl.hpp"
 #include "config_impl.hpp"
 
 #include "internal_impl.hpp"
@@ -37,10 +40,14 @@ namespace stats {
 
 metrics::gauge size;
 metrics::gauge process_time;
+metrics::counter evicted_count;
+metrics::counter overflow_count;
 
 void update(const chrono::time_point& timestamp) {
 	size.update_statistics(timestamp);
 	process_time.update_statistics(timestamp);
+	evicted_count.update_statistics(timestamp);
+	overflow_count.update_statistics(timestamp);
 }
 
 static void reset() {
@@ -55,6 +62,16 @@ static void reset() {
 	process_time_opts.values.moving_interval = chrono::duration(1, chrono::time_unit::SEC);
 
 	process_time = metrics::gauge(process_time_opts);
+
+	config::metrics::counter evicted_count_opts;
+	evicted_count_opts.values.tags = statistics::tag::value;
+
+	evicted_count = metrics::counter(evicted_count_opts);
+
+	config::metrics::counter overflow_count_opts;
+	overflow_count_opts.values.tags = statistics::tag::value;
+
+	overflow_count = metrics::counter(overflow_count_opts);
 }
 
 void initialize() {
@@ -68,128 +85,377 @@ void finalize() {
 } // namespace stats
 
 
-std::map<std::string, metrics::metric_ptr_variant> metrics_map;
+metrics_map_type metrics_map;
+
+uint64_t generation = 1;
+
+std::vector<std::shared_ptr<removed_generation>> removed_metrics;
+uint64_t removed_metrics_since = 0;
+
+// cardinality limited pattern's registered metrics count and its overflow metrics
+struct pattern_state {
+	size_t size;
+	// overflow entries by event type (events::event_destination_type), nullptr until first folded event
+	metric_entry* overflow[4];
+
+	pattern_state()
+		: size(0)
+	{
+		std::fill(overflow, overflow + 4, nullptr);
+	}
+};
+
+static std::map<const config::pattern_options*, pattern_state> pattern_states;
+
+// number of last generations removed metrics history is kept for
+static const uint64_t REMOVED_METRICS_HISTORY = 64;
+
+/*
+ * Homogeneous storage of metrics of single type.
+ * Metrics are allocated from pool, live metrics are listed contiguously along with their registry entries
+ * so sweeps over metrics of the type need no type dispatch.
+ */
+template <typename Metric>
+class metric_storage {
+public:
+	typedef std::vector<std::pair<Metric*, metric_entry*>> list_type;
+
+	template <typename... Args>
+	Metric* create(metric_entry& entry, Args&&... args) {
+		Metric* metric = m_pool.create(std::forward<Args>(args)...);
+		entry.index = m_metrics.size();
+		m_metrics.push_back(std::make_pair(metric, &entry));
+		return metric;
+	}
+
+	void destroy(metric_entry& entry) {
+		auto& removed = m_metrics[entry.index];
+		m_pool.destroy(removed.first);
+
+		removed = m_metrics.back();
+		removed.second->index = entry.index;
+		m_metrics.pop_back();
+	}
+
+	const list_type& metrics() const {
+		return m_metrics;
+	}
+
+	// destroys all metrics, pool's memory is returned in whole chunks
+	void clear() {
+		for (auto metric_iter = m_metrics.begin(); metric_iter != m_metrics.end(); ++metric_iter) {
+			m_pool.destroy(metric_iter->first);
+		}
+		m_metrics.clear();
+		m_pool.release();
+	}
+
+private:
+	object_pool<Metric> m_pool;
+	list_type m_metrics;
+};
+
+static metric_storage<metrics::counter> counters;
+static metric_storage<metrics::gauge> gauges;
+static metric_storage<metrics::timer> timers;
+static metric_storage<metrics::attribute> attributes;
+
+static void delete_metric(metric_entry& entry) {
+	switch (entry.type) {
+		case metrics::metric_index::COUNTER:
+			counters.destroy(entry);
+			break;
+		case metrics::metric_index::GAUGE:
+			gauges.destroy(entry);
+			break;
+		case metrics::metric_index::TIMER:
+			timers.destroy(entry);
+			break;
+		case metrics::metric_index::ATTRIBUTE:
+			attributes.destroy(entry);
+			break;
+		default:
+			break;
+	}
+
+	entry.type = metric_entry::NO_METRIC;
+	entry.counter = nullptr;
+}
+
+void remove_metric(metrics_map_type::iterator metric_iter) {
+	if (generation > REMOVED_METRICS_HISTORY && removed_metrics_since < generation - REMOVED_METRICS_HISTORY) {
+		removed_metrics_since = generation - REMOVED_METRICS_HISTORY;
+
+		auto history_end = removed_metrics.begin();
+		while (history_end != removed_metrics.end() && (*history_end)->generation <= removed_metrics_since) {
+			++history_end;
+		}
+		removed_metrics.erase(removed_metrics.begin(), history_end);
+	}
+
+	if (removed_metrics.empty() || removed_metrics.back()->generation != generation) {
+		std::shared_ptr<removed_generation> current(new removed_generation());
+		current->generation = generation;
+		removed_metrics.push_back(current);
+	}
+	removed_metrics.back()->names.push_back(metric_iter->first);
+
+	if (metric_iter->second.pattern) {
+		--pattern_states[metric_iter->second.pattern].size;
+	}
+
+	if (metric_iter->second.overflow_pattern) {
+		metric_entry** overflow = pattern_states[metric_iter->second.overflow_pattern].overflow;
+		std::replace(overflow, overflow + 4, &metric_iter->second, (metric_entry*)nullptr);
+	}
+
+	delete_metric(metric_iter->second);
+	metrics_map.erase(metric_iter);
+}
 
 size_t size() {
 	return metrics_map.size();
 }
 
-void update_metrics(const chrono::time_point& timestamp) {
+static bool less_recently_updated(
+		const metrics_map_type::iterator& first,
+		const metrics_map_type::iterator& second
+	)
+{
+	return first->second.last_event_timestamp < second->second.last_event_timestamp;
+}
+
+// timer with running instances would lose their measurements if evicted
+static bool has_running_instances(metric_entry& entry, const chrono::time_point& timestamp) {
+	if (entry.type != metrics::metric_index::TIMER) {
+		return false;
+	}
+	entry.timer->check_idle_timeout(timestamp, true);
+	return entry.timer->running_instances() > 0;
+}
+
+// removes count least recently updated metrics except kept one
+static void evict_least_recently_updated(size_t count, const metric_entry* kept) {
+	std::vector<metrics_map_type::iterator> candidates;
+	candidates.reserve(metrics_map.size());
 	for (auto metric_iter = metrics_map.begin(); metric_iter != metrics_map.end(); ++metric_iter) {
-		switch (metric_iter->second.which()) {
-			case metrics::metric_index::GAUGE:
-			{
-				auto* gauge = boost::get<metrics::gauge*>(metric_iter->second);
-				gauge->update_statistics(timestamp);
-				break;
-			}
-			case metrics::metric_index::COUNTER:
+		if (&metric_iter->second != kept) {
+			candidates.push_back(metric_iter);
+		}
+	}
+
+	count = std::min(count, candidates.size());
+	std::nth_element(candidates.begin(), candidates.begin() + count, candidates.end(), less_recently_updated);
+
+	for (size_t index = 0; index < count; ++index) {
+		remove_metric(candidates[index]);
+	}
+}
+
+size_t evict_metrics(const chrono::time_point& timestamp) {
+	const auto& ttl = config::registry_opts.ttl;
+	const size_t& max_size = config::registry_opts.max_size;
+
+	size_t evicted = 0;
+
+	if (ttl.count() > 0) {
+		for (auto metric_iter = metrics_map.begin(); metric_iter != metrics_map.end(); ) {
+			auto current_iter = metric_iter++;
+			if (timestamp - current_iter->second.last_event_timestamp > ttl &&
+					!has_running_instances(current_iter->second, timestamp))
 			{
-				auto* counter = boost::get<metrics::counter*>(metric_iter->second);
-				counter->update_statistics(timestamp);
-				break;
+				remove_metric(current_iter);
+				++evicted;
 			}
-			case metrics::metric_index::TIMER:
-			{
-				auto* timer = boost::get<metrics::timer*>(metric_iter->second);
-				timer->update_statistics(timestamp);
-				break;
+		}
+	}
+
+	if (max_size > 0 && metrics_map.size() > max_size) {
+		const size_t excess = metrics_map.size() - max_size;
+		evict_least_recently_updated(excess, nullptr);
+		evicted += excess;
+	}
+
+	if (evicted > 0) {
+		stats::evicted_count.increment(evicted, timestamp);
+	}
+
+	return evicted;
+}
+
+/*
+ * Registry is kept within max-size on insertion as well.
+ * Least recently updated metrics are evicted with slack of max-size / 16,
+ * so sweep over registry is amortized over insertions of new metrics.
+ */
+static void enforce_max_size(const metric_entry& inserted, const chrono::time_point& timestamp) {
+	const size_t& max_size = config::registry_opts.max_size;
+
+	if (max_size == 0 || metrics_map.size() <= max_size) {
+		return;
+	}
+
+	const size_t evicted = std::min(metrics_map.size() - max_size + max_size / 16, metrics_map.size() - 1);
+	evict_least_recently_updated(evicted, &inserted);
+
+	stats::evicted_count.increment(evicted, timestamp);
+}
+
+/*
+ * Statistics that change without events: moving window values and rate decay over time.
+ * Captured before and after update of statistics to detect changes of idle metrics.
+ */
+struct decaying_values {
+	double moving_count;
+	double moving_sum;
+	double rate;
+	double histogram_count;
+
+	explicit decaying_values(const statistics& values)
+		: moving_count(values.get_safe<statistics::tag::moving_count>())
+		, moving_sum(values.get_safe<statistics::tag::moving_sum>())
+		, rate(values.get_safe<statistics::tag::rate>())
+		, histogram_count(0)
+	{
+		if (values.computed(statistics::tag::histogram)) {
+			const auto& histogram = values.get<statistics::tag::histogram>();
+			for (auto bin = histogram.cbegin(); bin != histogram.cend(); ++bin) {
+				histogram_count += std::get<statistics::BIN_COUNT>(*bin);
 			}
-			case metrics::metric_index::ATTRIBUTE:
-				break;
 		}
 	}
+
+	bool operator!= (const decaying_values& other) const {
+		return moving_count != other.moving_count || moving_sum != other.moving_sum ||
+			rate != other.rate || histogram_count != other.histogram_count;
+	}
+};
+
+// updates statistics of metrics, metrics with decayed values are marked as modified
+template <typename Metric>
+static void update_metrics(const metric_storage<Metric>& storage, const chrono::time_point& timestamp) {
+	for (auto metric_iter = storage.metrics().begin(); metric_iter != storage.metrics().end(); ++metric_iter) {
+		const decaying_values previous_values(metric_iter->first->values());
+		metric_iter->first->update_statistics(timestamp);
+		if (decaying_values(metric_iter->first->values()) != previous_values) {
+			metric_iter->second->modified_generation = generation;
+		}
+	}
+}
+
+void update_metrics(const chrono::time_point& timestamp) {
+	update_metrics(gauges, timestamp);
+	update_metrics(counters, timestamp);
+	update_metrics(timers, timestamp);
 }
 
-void process_event_message(metrics::metric_ptr_variant& metric_ptr, const events::event_message& message) {
-	switch (metric_ptr.which()) {
+static void process_event_message(metric_entry& entry, const events::event_message& message) {
+	switch (entry.type) {
 		case metrics::metric_index::COUNTER:
-			events::counter::process_event(*boost::get<metrics::counter*>(metric_ptr), message);
+			events::counter::process_event(*entry.counter, message);
 			break;
 		case metrics::metric_index::GAUGE:
-			events::gauge::process_event(*boost::get<metrics::gauge*>(metric_ptr), message);
+			events::gauge::process_event(*entry.gauge, message);
 			break;
 		case metrics::metric_index::TIMER:
-			events::timer::process_event(*boost::get<metrics::timer*>(metric_ptr), message);
+			events::timer::process_event(*entry.timer, message);
 			break;
 		case metrics::metric_index::ATTRIBUTE:
-			events::attribute::process_event(*boost::get<metrics::attribute*>(metric_ptr), message);
+			events::attribute::process_event(*entry.attribute, message);
 			break;
 		default:
 			return;
 	}
 }
 
-void process_event_message(const events::event_message& message) {
-	auto process_start_time = chrono::tsc_clock::now();
-
-	auto& metric_ptr = metrics_map[message.destination_name];
-
-	bool empty_metric = false;
-
-	switch (metric_ptr.which()) {
-		case metrics::metric_index::COUNTER:
-			if (boost::get<metrics::counter*>(metric_ptr) == 0) {
-				empty_metric = true;
-			}
+static void create_metric(
+		metric_entry& entry,
+		const char& destination_type,
+		const config::pattern_options* pattern_cfg
+	)
+{
+	switch (destination_type) {
+		case events::event_destination_type::COUNTER:
+			entry.counter = counters.create(entry, pattern_cfg ? pattern_cfg->counter : config::metrics::counter_opts);
+			entry.type = metrics::metric_index::COUNTER;
 			break;
-		case metrics::metric_index::GAUGE:
-			if (boost::get<metrics::gauge*>(metric_ptr) == 0) {
-				empty_metric = true;
-			}
+		case events::event_destination_type::GAUGE:
+			entry.gauge = gauges.create(entry, pattern_cfg ? pattern_cfg->gauge : config::metrics::gauge_opts);
+			entry.type = metrics::metric_index::GAUGE;
 			break;
-		case metrics::metric_index::TIMER:
-			if (boost::get<metrics::timer*>(metric_ptr) == 0) {
-				empty_metric = true;
-			}
+		case events::event_destination_type::TIMER:
+			entry.timer = timers.create(entry, pattern_cfg ? pattern_cfg->timer : config::metrics::timer_opts);
+			entry.type = metrics::metric_index::TIMER;
 			break;
-		case metrics::metric_index::ATTRIBUTE:
-			if (boost::get<metrics::attribute*>(metric_ptr) == 0) {
-				empty_metric = true;
-			}
+		case events::event_destination_type::ATTRIBUTE:
+			entry.attribute = attributes.create(entry);
+			entry.type = metrics::metric_index::ATTRIBUTE;
+			break;
+		default:
 			break;
 	}
+}
 
-	if (empty_metric) {
-		rapidjson::Value* pattern_cfg = config::select_pattern(message.destination_name);
+void process_event_message(const events::event_message& message) {
+	if (message.destination_type == events::event_destination_type::BATCH) {
+		for (auto* batched_message = events::batch::first_message(message);
+				batched_message != nullptr;
+				batched_message = events::batch::next_message(*batched_message)
+			)
+		{
+			process_event_message(*batched_message);
+		}
+		return;
+	}
 
-		switch (message.destination_type) {
-			case events::event_destination_type::COUNTER:
-				{
-					auto counter_opts = config::metrics::counter_opts;
-					if (pattern_cfg) {
-						counter_opts.configure(*pattern_cfg);
-					}
-					metric_ptr = new metrics::counter(counter_opts);
-					break;
-				}
-			case events::event_destination_type::GAUGE:
-				{
-					auto gauge_opts = config::metrics::gauge_opts;
-					if (pattern_cfg) {
-						gauge_opts.configure(*pattern_cfg);
-					}
-					metric_ptr = new metrics::gauge(gauge_opts);
-					break;
-				}
-			case events::event_destination_type::TIMER:
-				{
-					auto timer_opts = config::metrics::timer_opts;
-					if (pattern_cfg) {
-						timer_opts.configure(*pattern_cfg);
+	auto process_start_time = chrono::tsc_clock::now();
+
+	metric_entry* entry = nullptr;
+
+	// lookup first, so events of names folded into overflow metric allocate nothing
+	auto metric_iter = metrics_map.find(message.destination_name);
+	if (metric_iter != metrics_map.end() && metric_iter->second.type != metric_entry::NO_METRIC) {
+		entry = &metric_iter->second;
+	}
+	else {
+		const config::pattern_options* pattern_cfg = config::select_pattern(message.destination_name);
+		pattern_state* limited_pattern = nullptr;
+
+		if (pattern_cfg && pattern_cfg->max_metrics > 0) {
+			limited_pattern = &pattern_states[pattern_cfg];
+			if (limited_pattern->size >= pattern_cfg->max_metrics) {
+				// cardinality limit is reached, event is folded into pattern's overflow metric of the same type
+				stats::overflow_count.increment(1, message.timestamp);
+
+				metric_entry*& overflow = limited_pattern->overflow[size_t(message.destination_type)];
+				if (!overflow) {
+					overflow = &metrics_map[pattern_cfg->overflow_names[size_t(message.destination_type)]];
+					if (overflow->type == metric_entry::NO_METRIC) {
+						create_metric(*overflow, message.destination_type, pattern_cfg);
+						enforce_max_size(*overflow, message.timestamp);
 					}
-					metric_ptr = new metrics::timer(timer_opts);
-					break;
-				}
-			case events::event_destination_type::ATTRIBUTE:
-				{
-					metric_ptr = new metrics::attribute();
-					break;
+					overflow->overflow_pattern = pattern_cfg;
 				}
+				entry = overflow;
+			}
+		}
+
+		if (!entry) {
+			entry = (metric_iter != metrics_map.end()) ? &metric_iter->second : &metrics_map[message.destination_name];
+
+			create_metric(*entry, message.destination_type, pattern_cfg);
+			if (limited_pattern) {
+				++limited_pattern->size;
+				entry->pattern = pattern_cfg;
+			}
+			enforce_max_size(*entry, message.timestamp);
 		}
 	}
 
-	process_event_message(metric_ptr, message);
+	entry->modified_generation = generation;
+	entry->last_event_timestamp = message.timestamp;
+
+	process_event_message(*entry, message);
 
 	auto process_end_time = chrono::tsc_clock::now();
 
@@ -207,26 +473,17 @@ void initialize() {
 }
 
 void finalize() {
-	for (auto metric_iter = metrics_map.begin(); metric_iter != metrics_map.end(); ++metric_iter) {
-		switch (metric_iter->second.which()) {
-			case metrics::metric_index::COUNTER:
-				delete boost::get<metrics::counter*>(metric_iter->second);
-				break;
-			case metrics::metric_index::GAUGE:
-				delete boost::get<metrics::gauge*>(metric_iter->second);
-				break;
-			case metrics::metric_index::TIMER:
-				delete boost::get<metrics::timer*>(metric_iter->second);
-				break;
-			case metrics::metric_index::ATTRIBUTE:
-				delete boost::get<metrics::attribute*>(metric_iter->second);
-				break;
-			default:
-				break;
-		}
-	}
+	counters.clear();
+	gauges.clear();
+	timers.clear();
+	attributes.clear();
 
 	metrics_map.clear();
+	pattern_states.clear();
+
+	// generation is not reset, so deltas requested against previous session are full
+	removed_metrics.clear();
+	removed_metrics_since = generation;
 
 	stats::finalize();
 }
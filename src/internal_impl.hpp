@@ -19,10 +19,20 @@
 #define HANDYSTATS_INTERNAL_IMPL_HPP_
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
 
+#include <handystats/chrono.hpp>
 #include <handystats/metrics.hpp>
 #include <handystats/metrics/gauge.hpp>
+#include <handystats/metrics/counter.hpp>
+#include <handystats/metrics/timer.hpp>
+#include <handystats/metrics/attribute.hpp>
+
+#include "object_pool_impl.hpp"
 
 
 namespace handystats { namespace events {
@@ -31,13 +41,89 @@ struct event_message;
 
 }} // namespace handystats::events
 
+namespace handystats { namespace config {
+
+struct pattern_options;
+
+}} // namespace handystats::config
+
 
 namespace handystats { namespace internal {
 
-extern std::map<std::string, metrics::metric_ptr_variant> metrics_map;
+/*
+ * Registry entry.
+ * Metric is referenced by pointer of its type selected by type tag (metrics::metric_index),
+ * metrics themselves are kept in per-type storages, index is position of metric in its storage.
+ */
+struct metric_entry {
+	static const int NO_METRIC = -1;
+
+	int type;
+	union {
+		metrics::counter* counter;
+		metrics::gauge* gauge;
+		metrics::timer* timer;
+		metrics::attribute* attribute;
+	};
+	size_t index;
+
+	// dump generation in which metric was last modified
+	uint64_t modified_generation;
+	// timestamp of last event, used for eviction of idle metrics
+	chrono::time_point last_event_timestamp;
+	// pattern metric is counted against for cardinality limit, nullptr if not limited
+	const config::pattern_options* pattern;
+	// pattern whose overflow metric this is, nullptr for regular metrics
+	const config::pattern_options* overflow_pattern;
+
+	metric_entry()
+		: type(NO_METRIC)
+		, counter(nullptr)
+		, index(0)
+		, modified_generation(0)
+		, last_event_timestamp()
+		, pattern(nullptr)
+		, overflow_pattern(nullptr)
+	{}
+};
+
+// map nodes are allocated from pool, so registry entries are placed close to each other
+typedef std::map<
+		std::string, metric_entry,
+		std::less<std::string>,
+		pool_allocator<std::pair<const std::string, metric_entry>>
+	>
+	metrics_map_type;
+
+extern metrics_map_type metrics_map;
+
+/*
+ * Dump generation.
+ * Monotonically increasing (never reset), events processed between dumps N - 1 and N
+ * are marked with generation N.
+ */
+extern uint64_t generation;
+
+// names of metrics removed during single generation, not modified once the generation is dumped
+struct removed_generation {
+	uint64_t generation;
+	std::vector<std::string> names;
+};
+
+// removed metrics history ordered by generation, dumps share its entries instead of copying names
+extern std::vector<std::shared_ptr<removed_generation>> removed_metrics;
+// removed metrics are known for generations above this one
+extern uint64_t removed_metrics_since;
+
+// deletes metric from registry and records it in removed_metrics history
+void remove_metric(metrics_map_type::iterator metric_iter);
 
 void update_metrics(const chrono::time_point&);
 
+// evicts metrics idle for longer than registry ttl and least recently updated ones above registry max-size
+// returns number of evicted metrics
+size_t evict_metrics(const chrono::time_point&);
+
 void process_event_message(const events::event_message&);
 
 size_t size();
@@ -50,6 +136,8 @@ namespace stats {
 
 extern metrics::gauge size;
 extern metrics::gauge process_time;
+extern metrics::counter evicted_count;
+extern metrics::counter overflow_count;
 
 void update(const chrono::time_point&);
 
@@ -17,25 +17,51 @@
 
 #include <handystats/json_dump.hpp>
 
+#include "output_stream_impl.hpp"
+#include "config_impl.hpp"
+#include "metrics_dump_impl.hpp"
+#include "dump_filter_impl.hpp"
+
 namespace handystats { namespace json {
 
-std::string to_string(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map) {
-	typedef rapidjson::MemoryPoolAllocator<> allocator_type;
+std::string to_string(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, const bool& pretty) {
+	std::string buffer;
+	write_to_string(metrics_map, buffer, pretty);
+	return buffer;
+}
 
-	rapidjson::Value dump;
-	allocator_type allocator;
-	fill(dump, allocator, metrics_map);
+void write_to_string(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, std::string& buffer, const bool& pretty) {
+	string_output_stream stream(buffer);
+	write_to_stream(metrics_map, stream, pretty);
+}
 
-	rapidjson::GenericStringBuffer<rapidjson::UTF8<>, allocator_type> buffer(&allocator);
-	rapidjson::PrettyWriter<rapidjson::GenericStringBuffer<rapidjson::UTF8<>, allocator_type>> writer(buffer);
-	dump.Accept(writer);
+void write_to_string(
+		const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, std::string& buffer,
+		const bool& pretty, const metrics_dump::tags_filter& tags_filter
+	)
+{
+	string_output_stream stream(buffer);
+	write_to_stream(metrics_map, stream, pretty, tags_filter);
+}
 
-	return std::string(buffer.GetString(), buffer.GetSize());
+bool write_to_fd(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, const int& fd, const bool& pretty) {
+	fd_output_stream stream(fd);
+	write_to_stream(metrics_map, stream, pretty);
+	stream.Flush();
+	return !stream.failed;
 }
 
 }} // namespace handystats::json
 
-std::string HANDY_JSON_DUMP() {
-	return handystats::json::to_string(*HANDY_METRICS_DUMP());
+std::shared_ptr<const std::string> HANDY_JSON_DUMP_SHARED() {
+	auto rendered_dump = handystats::metrics_dump::get_rendered_dump(handystats::config::dump_format::JSON);
+	if (rendered_dump) {
+		return rendered_dump;
+	}
+
+	return std::shared_ptr<const std::string>(new std::string(handystats::json::to_string(*HANDY_METRICS_DUMP())));
 }
 
+std::string HANDY_JSON_DUMP() {
+	return *HANDY_JSON_DUMP_SHARED();
+}
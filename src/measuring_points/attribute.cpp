@@ -53,7 +53,7 @@ void attribute_set<bool>(
 		handystats::message_queue::push(
 				handystats::events::attribute::create_set_event(
 					std::move(attribute_name),
-					handystats::metrics::attribute::value_type(b),
+					b,
 					timestamp
 				)
 			);
@@ -71,7 +71,7 @@ void attribute_set<int>(
 		handystats::message_queue::push(
 				handystats::events::attribute::create_set_event(
 					std::move(attribute_name),
-					handystats::metrics::attribute::value_type(i),
+					i,
 					timestamp
 				)
 			);
@@ -89,7 +89,7 @@ void attribute_set<unsigned>(
 		handystats::message_queue::push(
 				handystats::events::attribute::create_set_event(
 					std::move(attribute_name),
-					handystats::metrics::attribute::value_type(u),
+					u,
 					timestamp
 				)
 			);
@@ -107,7 +107,7 @@ void attribute_set<int64_t>(
 		handystats::message_queue::push(
 				handystats::events::attribute::create_set_event(
 					std::move(attribute_name),
-					handystats::metrics::attribute::value_type(i64),
+					i64,
 					timestamp
 				)
 			);
@@ -125,7 +125,7 @@ void attribute_set<uint64_t>(
 		handystats::message_queue::push(
 				handystats::events::attribute::create_set_event(
 					std::move(attribute_name),
-					handystats::metrics::attribute::value_type(u64),
+					u64,
 					timestamp
 				)
 			);
@@ -143,7 +143,7 @@ void attribute_set<double>(
 		handystats::message_queue::push(
 				handystats::events::attribute::create_set_event(
 					std::move(attribute_name),
-					handystats::metrics::attribute::value_type(d),
+					d,
 					timestamp
 				)
 			);
@@ -161,7 +161,7 @@ void attribute_set<std::string>(
 		handystats::message_queue::push(
 				handystats::events::attribute::create_set_event(
 					std::move(attribute_name),
-					handystats::metrics::attribute::value_type(s),
+					s.data(), s.size(),
 					timestamp
 				)
 			);
@@ -0,0 +1,328 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <algorithm>
+
+#include "events/event_message_impl.hpp"
+#include "events/counter_impl.hpp"
+#include "events/gauge_impl.hpp"
+#include "events/timer_impl.hpp"
+#include "events/attribute_impl.hpp"
+#include "events/batch_impl.hpp"
+#include "message_queue_impl.hpp"
+#include "core_impl.hpp"
+
+#include <handystats/measuring_points/batch.hpp>
+
+
+namespace handystats { namespace measuring_points {
+
+batch::batch()
+	: m_first(nullptr)
+	, m_last(nullptr)
+	, m_size(0)
+	, m_timestamp()
+{
+}
+
+batch::~batch() {
+	submit();
+}
+
+void batch::append(events::event_message* message) {
+	message->next.store(nullptr, std::memory_order_relaxed);
+
+	if (m_last) {
+		m_last->next.store(message, std::memory_order_relaxed);
+	}
+	else {
+		m_first = message;
+	}
+	m_last = message;
+
+	m_size++;
+	m_timestamp = std::max(m_timestamp, message->timestamp);
+}
+
+void batch::submit() {
+	if (!m_first) {
+		return;
+	}
+
+	if (!handystats::is_enabled()) {
+		discard();
+		return;
+	}
+
+	if (m_size == 1) {
+		handystats::message_queue::push(m_first);
+	}
+	else {
+		handystats::message_queue::push(
+				handystats::events::batch::create_submit_event(m_first, m_timestamp)
+			);
+	}
+
+	m_first = m_last = nullptr;
+	m_size = 0;
+	m_timestamp = chrono::time_point();
+}
+
+void batch::discard() {
+	events::event_message* message = m_first;
+	while (message) {
+		events::event_message* next = message->next.load(std::memory_order_relaxed);
+		events::delete_event_message(message);
+		message = next;
+	}
+
+	m_first = m_last = nullptr;
+	m_size = 0;
+	m_timestamp = chrono::time_point();
+}
+
+size_t batch::size() const {
+	return m_size;
+}
+
+bool batch::empty() const {
+	return m_size == 0;
+}
+
+
+void batch::counter_init(
+		std::string&& counter_name,
+		const metrics::counter::value_type& init_value,
+		const metrics::counter::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::counter::create_init_event(std::move(counter_name), init_value, timestamp));
+	}
+}
+
+void batch::counter_increment(
+		std::string&& counter_name,
+		const metrics::counter::value_type& value,
+		const metrics::counter::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::counter::create_increment_event(std::move(counter_name), value, timestamp));
+	}
+}
+
+void batch::counter_decrement(
+		std::string&& counter_name,
+		const metrics::counter::value_type& value,
+		const metrics::counter::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::counter::create_decrement_event(std::move(counter_name), value, timestamp));
+	}
+}
+
+void batch::counter_change(
+		std::string&& counter_name,
+		const metrics::counter::value_type& value,
+		const metrics::counter::time_point& timestamp
+	)
+{
+	if (value >= 0) {
+		counter_increment(std::move(counter_name), value, timestamp);
+	}
+	else {
+		counter_decrement(std::move(counter_name), -value, timestamp);
+	}
+}
+
+
+void batch::gauge_init(
+		std::string&& gauge_name,
+		const metrics::gauge::value_type& init_value,
+		const metrics::gauge::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::gauge::create_init_event(std::move(gauge_name), init_value, timestamp));
+	}
+}
+
+void batch::gauge_set(
+		std::string&& gauge_name,
+		const metrics::gauge::value_type& value,
+		const metrics::gauge::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::gauge::create_set_event(std::move(gauge_name), value, timestamp));
+	}
+}
+
+
+void batch::timer_init(
+		std::string&& timer_name,
+		const metrics::timer::instance_id_type& instance_id,
+		const metrics::timer::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::timer::create_init_event(std::move(timer_name), instance_id, timestamp));
+	}
+}
+
+void batch::timer_start(
+		std::string&& timer_name,
+		const metrics::timer::instance_id_type& instance_id,
+		const metrics::timer::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::timer::create_start_event(std::move(timer_name), instance_id, timestamp));
+	}
+}
+
+void batch::timer_stop(
+		std::string&& timer_name,
+		const metrics::timer::instance_id_type& instance_id,
+		const metrics::timer::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::timer::create_stop_event(std::move(timer_name), instance_id, timestamp));
+	}
+}
+
+void batch::timer_discard(
+		std::string&& timer_name,
+		const metrics::timer::instance_id_type& instance_id,
+		const metrics::timer::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::timer::create_discard_event(std::move(timer_name), instance_id, timestamp));
+	}
+}
+
+void batch::timer_heartbeat(
+		std::string&& timer_name,
+		const metrics::timer::instance_id_type& instance_id,
+		const metrics::timer::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::timer::create_heartbeat_event(std::move(timer_name), instance_id, timestamp));
+	}
+}
+
+void batch::timer_set(
+		std::string&& timer_name,
+		const metrics::timer::value_type& measurement,
+		const metrics::timer::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::timer::create_set_event(std::move(timer_name), measurement, timestamp));
+	}
+}
+
+
+void batch::attribute_set(
+		std::string&& attribute_name,
+		const metrics::attribute::value_type& value,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	if (handystats::is_enabled()) {
+		append(events::attribute::create_set_event(std::move(attribute_name), value, timestamp));
+	}
+}
+
+void batch::attribute_set(
+		std::string&& attribute_name,
+		const bool& b,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	attribute_set(std::move(attribute_name), metrics::attribute::value_type(b), timestamp);
+}
+
+void batch::attribute_set(
+		std::string&& attribute_name,
+		const int& i,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	attribute_set(std::move(attribute_name), metrics::attribute::value_type(i), timestamp);
+}
+
+void batch::attribute_set(
+		std::string&& attribute_name,
+		const unsigned& u,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	attribute_set(std::move(attribute_name), metrics::attribute::value_type(u), timestamp);
+}
+
+void batch::attribute_set(
+		std::string&& attribute_name,
+		const int64_t& i64,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	attribute_set(std::move(attribute_name), metrics::attribute::value_type(i64), timestamp);
+}
+
+void batch::attribute_set(
+		std::string&& attribute_name,
+		const uint64_t& u64,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	attribute_set(std::move(attribute_name), metrics::attribute::value_type(u64), timestamp);
+}
+
+void batch::attribute_set(
+		std::string&& attribute_name,
+		const double& d,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	attribute_set(std::move(attribute_name), metrics::attribute::value_type(d), timestamp);
+}
+
+void batch::attribute_set(
+		std::string&& attribute_name,
+		const char* s,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	attribute_set(std::move(attribute_name), metrics::attribute::value_type(std::string(s)), timestamp);
+}
+
+void batch::attribute_set(
+		std::string&& attribute_name,
+		const std::string& s,
+		const metrics::attribute::time_point& timestamp
+	)
+{
+	attribute_set(std::move(attribute_name), metrics::attribute::value_type(s), timestamp);
+}
+
+}} // namespace handystats::measuring_points
@@ -0,0 +1,26 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <handystats/measuring_points/clock.hpp>
+
+
+namespace handystats { namespace measuring_points {
+
+coarse_timestamp_flag_type counter_coarse_timestamp(false);
+coarse_timestamp_flag_type gauge_coarse_timestamp(false);
+
+}} // namespace handystats::measuring_points
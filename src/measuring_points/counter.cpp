@@ -75,10 +75,10 @@ void counter_change(
 {
 	if (handystats::is_enabled()) {
 		if (value >= 0) {
-			HANDY_COUNTER_INCREMENT(std::move(counter_name), value, timestamp);
+			counter_increment(std::move(counter_name), value, timestamp);
 		}
 		else {
-			HANDY_COUNTER_DECREMENT(std::move(counter_name), -value, timestamp);
+			counter_decrement(std::move(counter_name), -value, timestamp);
 		}
 	}
 }
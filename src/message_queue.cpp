@@ -17,6 +17,10 @@
 
 #include <handystats/atomic.hpp>
 #include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include <pthread.h>
 
 #include <handystats/chrono.hpp>
 #include <handystats/metrics/timer.hpp>
@@ -157,12 +161,111 @@ void finalize() {
 
 __event_message_queue* event_message_queue = nullptr;
 
-std::atomic<size_t> mq_size(0);
+/*
+ * Queue size accounting.
+ *
+ * Each producer thread owns a push counter placed on its own cache line
+ * and updates it with plain store (no shared read-modify-write on push path).
+ * Pop counter is owned by the processor thread.
+ * Queue size is derived as sum of push counters minus pop counter.
+ *
+ * Producer slots are never freed, on thread exit slot is released and
+ * could be acquired by another producer thread (push counter is cumulative).
+ * Pushes made after the release (from other TLS destructors) go to shared atomic counter.
+ */
+struct producer_slot {
+	std::atomic<size_t> push_count;
+	std::atomic<bool> acquired;
+	producer_slot* next;
+} __attribute__((aligned(64)));
+
+std::atomic<producer_slot*> producer_slots(nullptr);
+
+std::atomic<size_t> popped_count(0);
+
+static __thread producer_slot* local_producer_slot = nullptr;
+// set once thread's slot is released, later pushes from TLS destructors use shared counter
+static __thread bool local_producer_slot_released = false;
+
+// push counter for threads whose slot is already released
+std::atomic<size_t> shared_push_count(0);
+
+static pthread_key_t producer_slot_key;
+static pthread_once_t producer_slot_key_once = PTHREAD_ONCE_INIT;
+
+static void release_producer_slot(void* slot) {
+	local_producer_slot = nullptr;
+	local_producer_slot_released = true;
+
+	static_cast<producer_slot*>(slot)->acquired.store(false, std::memory_order_release);
+}
+
+static void create_producer_slot_key() {
+	pthread_key_create(&producer_slot_key, release_producer_slot);
+}
+
+static producer_slot* acquire_producer_slot() {
+	producer_slot* slot = producer_slots.load(std::memory_order_acquire);
+	for (; slot != nullptr; slot = slot->next) {
+		bool acquired = false;
+		if (!slot->acquired.load(std::memory_order_relaxed) &&
+				slot->acquired.compare_exchange_strong(acquired, true, std::memory_order_acquire)
+			)
+		{
+			break;
+		}
+	}
+
+	if (!slot) {
+		void* slot_memory = nullptr;
+		if (posix_memalign(&slot_memory, sizeof(producer_slot), sizeof(producer_slot)) != 0) {
+			throw std::bad_alloc();
+		}
+
+		slot = new (slot_memory) producer_slot;
+		slot->push_count.store(0, std::memory_order_relaxed);
+		slot->acquired.store(true, std::memory_order_relaxed);
+
+		slot->next = producer_slots.load(std::memory_order_relaxed);
+		while (!producer_slots.compare_exchange_weak(slot->next, slot, std::memory_order_release)) {
+		}
+	}
+
+	pthread_once(&producer_slot_key_once, create_producer_slot_key);
+	pthread_setspecific(producer_slot_key, slot);
+
+	return slot;
+}
+
+static size_t pushed_count() {
+	size_t count = shared_push_count.load(std::memory_order_acquire);
+	for (producer_slot* slot = producer_slots.load(std::memory_order_acquire); slot != nullptr; slot = slot->next) {
+		count += slot->push_count.load(std::memory_order_acquire);
+	}
+	return count;
+}
+
+// processor's view of pushed messages, refreshed when known messages are drained
+static size_t known_pushed_count = 0;
+
+static const size_t SIZE_RESYNC_INTERVAL = 64;
 
 void push(node* n) {
 	if (event_message_queue) {
+		producer_slot* slot = local_producer_slot;
+		if (!slot && !local_producer_slot_released) {
+			slot = local_producer_slot = acquire_producer_slot();
+		}
+
+		// counted before message becomes visible to processor, so size never underflows
+		if (slot) {
+			slot->push_count.store(slot->push_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		else {
+			shared_push_count.fetch_add(1, std::memory_order_relaxed);
+		}
+
 		event_message_queue->push(n);
-		++mq_size;
 	}
 }
 
@@ -174,9 +277,15 @@ events::event_message* pop() {
 	}
 
 	if (message) {
-		--mq_size;
+		const size_t popped = popped_count.load(std::memory_order_relaxed) + 1;
+		popped_count.store(popped, std::memory_order_release);
+
+		if (popped >= known_pushed_count || popped % SIZE_RESYNC_INTERVAL == 0) {
+			known_pushed_count = pushed_count();
+		}
+
 		auto current_time = chrono::tsc_clock::now();
-		stats::size.set(size(), current_time);
+		stats::size.set(known_pushed_count - popped, current_time);
 		stats::pop_count.increment(1, current_time);
 
 		stats::message_wait_time.set(
@@ -189,28 +298,40 @@ events::event_message* pop() {
 }
 
 bool empty() {
-	return mq_size.load(std::memory_order_acquire) == 0;
+	return size() == 0;
 }
 
 size_t size() {
-	return mq_size.load(std::memory_order_acquire);
+	// pop counter is loaded first: every popped message is already counted as pushed
+	const size_t popped = popped_count.load(std::memory_order_acquire);
+	const size_t pushed = pushed_count();
+
+	return pushed > popped ? pushed - popped : 0;
+}
+
+static void reset_size() {
+	known_pushed_count = pushed_count();
+	popped_count.store(known_pushed_count, std::memory_order_release);
 }
 
 void initialize() {
 	if (!event_message_queue) {
 		event_message_queue = new __event_message_queue();
-		mq_size.store(0, std::memory_order_release);
+		reset_size();
 	}
 
 	stats::initialize();
 }
 
 void finalize() {
+	// pop() could return nullptr while producer is linking pushed message, so drain by size
 	while (!empty()) {
 		auto* message = pop();
-		events::delete_event_message(message);
+		if (message) {
+			events::delete_event_message(message);
+		}
 	}
-	mq_size.store(0);
+	reset_size();
 
 	delete event_message_queue;
 	event_message_queue = nullptr;
@@ -111,6 +111,10 @@ void timer::update_statistics(const time_point& timestamp) {
 	m_values.update_time(timestamp);
 }
 
+size_t timer::running_instances() const {
+	return m_instances.size();
+}
+
 const statistics& timer::values() const {
 	return m_values;
 }
@@ -18,16 +18,24 @@
 #include <mutex>
 #include <string>
 #include <map>
+#include <vector>
 
 #include <handystats/chrono.hpp>
 #include <handystats/metrics_dump.hpp>
+#include <handystats/json_dump.hpp>
+#include <handystats/prometheus_dump.hpp>
+#include <handystats/binary_dump.hpp>
 
 #include "internal_impl.hpp"
 #include "message_queue_impl.hpp"
+#include "chrono_impl.hpp"
 
 #include "config_impl.hpp"
+#include "shm_export_impl.hpp"
+#include "push_export_impl.hpp"
 
 #include "metrics_dump_impl.hpp"
+#include "dump_filter_impl.hpp"
 
 
 namespace handystats { namespace metrics_dump {
@@ -63,8 +71,30 @@ void finalize() {
 chrono::time_point dump_timestamp;
 std::mutex dump_mutex;
 
+typedef std::map<std::string, metrics::metric_variant> dump_type;
+
+// dump's entries copied from internal::metrics_map with their modification generations
+typedef std::vector<std::pair<dump_type::const_iterator, uint64_t>> dump_generations_type;
+
+// removed metrics history as of dump creation, generations are shared with internal history
+typedef std::vector<std::shared_ptr<const internal::removed_generation>> dump_removed_type;
+
 std::shared_ptr<const std::map<std::string, metrics::metric_variant>> dump(new std::map<std::string, metrics::metric_variant>());
 
+// delta state is replaced together with dump under dump_mutex
+uint64_t dump_generation = 0;
+std::shared_ptr<const dump_generations_type> dump_generations(new dump_generations_type());
+std::shared_ptr<const dump_removed_type> dump_removed(new dump_removed_type());
+uint64_t dump_removed_since = 0;
+
+// statistics selected by dump-filter for dump's metrics, replaced together with dump under dump_mutex
+tags_filter dump_tags_filter;
+
+// rendered dumps are replaced together with dump under dump_mutex
+std::map<int, std::shared_ptr<const std::string>> rendered_dumps;
+// serializes lazy rendering of formats not rendered on dump update
+std::mutex render_mutex;
+
 const std::shared_ptr<const std::map<std::string, metrics::metric_variant>>
 get_dump()
 {
@@ -72,63 +102,248 @@ get_dump()
 	return dump;
 }
 
+delta
+get_dump_delta(const uint64_t& since)
+{
+	std::shared_ptr<const dump_type> current_dump;
+	std::shared_ptr<const dump_generations_type> generations;
+	std::shared_ptr<const dump_removed_type> removed;
+	delta result;
+	{
+		std::lock_guard<std::mutex> lock(dump_mutex);
+		current_dump = dump;
+		generations = dump_generations;
+		removed = dump_removed;
+		result.generation = dump_generation;
+		result.full = (since == 0) || (since < dump_removed_since) || (since > dump_generation);
+	}
+
+	if (result.full) {
+		result.changed = *current_dump;
+		return result;
+	}
+
+	// generations are in the same order as dump entries they refer to,
+	// entries not found in generations are internal metrics
+	auto generation_iter = generations->cbegin();
+	auto hint = result.changed.end();
+	for (auto metric_iter = current_dump->cbegin(); metric_iter != current_dump->cend(); ++metric_iter) {
+		if (generation_iter != generations->cend() && generation_iter->first == metric_iter) {
+			const bool changed = generation_iter->second > since;
+			++generation_iter;
+			if (!changed) {
+				continue;
+			}
+		}
+		hint = result.changed.insert(hint, *metric_iter);
+	}
+
+	for (auto removed_iter = removed->crbegin(); removed_iter != removed->crend() && (*removed_iter)->generation > since; ++removed_iter) {
+		const std::vector<std::string>& names = (*removed_iter)->names;
+		for (auto name_iter = names.crbegin(); name_iter != names.crend(); ++name_iter) {
+			// metric could be created again after removal
+			if (current_dump->find(*name_iter) == current_dump->end()) {
+				result.removed.push_back(*name_iter);
+			}
+		}
+	}
+
+	return result;
+}
+
+tags_filter snapshot_tags_filter(const std::map<std::string, metrics::metric_variant>& dump) {
+	if (config::dump_filter_opts.empty()) {
+		return tags_filter();
+	}
+
+	std::shared_ptr<tags_filter::tags_map> tags(new tags_filter::tags_map());
+	for (auto metric_iter = dump.cbegin(); metric_iter != dump.cend(); ++metric_iter) {
+		if (metric_iter->second.which() == metrics::metric_index::ATTRIBUTE) {
+			continue;
+		}
+
+		const statistics::tag::type metric_tags = config::select_dump_tags(metric_iter->first);
+		if (metric_tags != ~statistics::tag::empty) {
+			tags->insert(std::make_pair(metric_iter->first, metric_tags));
+		}
+	}
+
+	return tags_filter(std::const_pointer_cast<const tags_filter::tags_map>(tags));
+}
+
+// previous rendering (if any) is used to estimate buffer size
+static
+std::shared_ptr<const std::string>
+render_dump(
+		const int& format,
+		const std::map<std::string, metrics::metric_variant>& metrics_map,
+		const tags_filter& filter,
+		const std::shared_ptr<const std::string>& previous
+	)
+{
+	std::shared_ptr<std::string> rendered(new std::string());
+	if (previous) {
+		rendered->reserve(previous->size() + previous->size() / 8);
+	}
+
+	switch (format) {
+		case config::dump_format::JSON:
+			json::write_to_string(metrics_map, *rendered, true, filter);
+			break;
+		case config::dump_format::PROMETHEUS:
+			prometheus::write_to_string(metrics_map, *rendered, filter);
+			break;
+		case config::dump_format::BINARY:
+			binary::write_to_string(metrics_map, *rendered, filter);
+			break;
+		default:
+			return std::shared_ptr<const std::string>();
+	}
+
+	return std::const_pointer_cast<const std::string>(rendered);
+}
+
+static
+std::map<int, std::shared_ptr<const std::string>>
+render_dumps(const std::map<std::string, metrics::metric_variant>& metrics_map, const tags_filter& filter)
+{
+	static const int formats[] = {
+		config::dump_format::JSON,
+		config::dump_format::PROMETHEUS,
+		config::dump_format::BINARY,
+	};
+
+	std::map<int, std::shared_ptr<const std::string>> previous_dumps;
+	{
+		std::lock_guard<std::mutex> lock(dump_mutex);
+		previous_dumps = rendered_dumps;
+	}
+
+	std::map<int, std::shared_ptr<const std::string>> new_dumps;
+	for (size_t index = 0; index < sizeof(formats) / sizeof(formats[0]); ++index) {
+		const int& format = formats[index];
+		if (config::metrics_dump_opts.formats & format) {
+			new_dumps[format] = render_dump(format, metrics_map, filter, previous_dumps[format]);
+		}
+	}
+
+	return new_dumps;
+}
+
+const std::shared_ptr<const std::string>
+get_rendered_dump(const int& format)
+{
+	{
+		std::lock_guard<std::mutex> lock(dump_mutex);
+		auto rendered_iter = rendered_dumps.find(format);
+		if (rendered_iter != rendered_dumps.end()) {
+			return rendered_iter->second;
+		}
+	}
+
+	std::shared_ptr<const dump_type> current_dump;
+	tags_filter current_filter;
+
+	// concurrent readers of the same dump wait for single rendering
+	std::lock_guard<std::mutex> render_lock(render_mutex);
+	{
+		std::lock_guard<std::mutex> lock(dump_mutex);
+		auto rendered_iter = rendered_dumps.find(format);
+		if (rendered_iter != rendered_dumps.end()) {
+			return rendered_iter->second;
+		}
+		current_dump = dump;
+		current_filter = dump_tags_filter;
+	}
+
+	auto rendered = render_dump(format, *current_dump, current_filter, std::shared_ptr<const std::string>());
+	if (rendered) {
+		std::lock_guard<std::mutex> lock(dump_mutex);
+		// rendered dumps are dropped on dump update, so rendering of replaced dump is not cached
+		if (dump == current_dump) {
+			rendered_dumps[format] = rendered;
+		}
+	}
+	return rendered;
+}
+
+static bool cardinality_limited() {
+	for (auto pattern_iter = config::pattern_opts.cbegin(); pattern_iter != config::pattern_opts.cend(); ++pattern_iter) {
+		if (pattern_iter->second.max_metrics > 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
 static
 std::shared_ptr<const std::map<std::string, metrics::metric_variant>>
-create_dump()
+create_dump(dump_generations_type& generations)
 {
 	auto dump_start_time = chrono::tsc_clock::now();
 
 	std::shared_ptr<std::map<std::string, metrics::metric_variant>> new_dump(new std::map<std::string, metrics::metric_variant>());
 
+	generations.reserve(internal::metrics_map.size());
+
+	// registry is ordered by name, so each entry is appended to the end of dump
 	for (auto metric_iter = internal::metrics_map.cbegin(); metric_iter != internal::metrics_map.cend(); ++metric_iter) {
-		switch (metric_iter->second.which()) {
+		switch (metric_iter->second.type) {
 			case metrics::metric_index::GAUGE:
 				{
-					const auto& metric = *boost::get<metrics::gauge*>(metric_iter->second);
+					const auto& metric = *metric_iter->second.gauge;
 					if (metric.values().tags() != statistics::tag::empty) {
-						new_dump->insert(
+						auto dump_iter = new_dump->insert(
+								new_dump->end(),
 								std::pair<std::string, metrics::metric_variant>(
 									metric_iter->first,
 									metric
 								)
 							);
+						generations.push_back(std::make_pair(dump_iter, metric_iter->second.modified_generation));
 					}
 					break;
 				}
 			case metrics::metric_index::COUNTER:
 				{
-					const auto& metric = *boost::get<metrics::counter*>(metric_iter->second);
+					const auto& metric = *metric_iter->second.counter;
 					if (metric.values().tags() != statistics::tag::empty) {
-						new_dump->insert(
+						auto dump_iter = new_dump->insert(
+								new_dump->end(),
 								std::pair<std::string, metrics::metric_variant>(
 									metric_iter->first,
 									metric
 								)
 							);
+						generations.push_back(std::make_pair(dump_iter, metric_iter->second.modified_generation));
 					}
 					break;
 				}
 			case metrics::metric_index::TIMER:
 				{
-					const auto& metric = *boost::get<metrics::timer*>(metric_iter->second);
+					const auto& metric = *metric_iter->second.timer;
 					if (metric.values().tags() != statistics::tag::empty) {
-						new_dump->insert(
+						auto dump_iter = new_dump->insert(
+								new_dump->end(),
 								std::pair<std::string, metrics::metric_variant>(
 									metric_iter->first,
 									metric
 								)
 							);
+						generations.push_back(std::make_pair(dump_iter, metric_iter->second.modified_generation));
 					}
 					break;
 				}
 			case metrics::metric_index::ATTRIBUTE:
 				{
-					new_dump->insert(
+					auto dump_iter = new_dump->insert(
+							new_dump->end(),
 							std::pair<std::string, metrics::metric_variant>(
 								metric_iter->first,
-								*boost::get<metrics::attribute*>(metric_iter->second)
+								*metric_iter->second.attribute
 							)
 						);
+					generations.push_back(std::make_pair(dump_iter, metric_iter->second.modified_generation));
 					break;
 				}
 		}
@@ -151,6 +366,34 @@ create_dump()
 						internal::stats::process_time
 						)
 					);
+
+			if (config::registry_opts.ttl.count() > 0 || config::registry_opts.max_size > 0) {
+				new_dump->insert(
+						std::pair<std::string, metrics::metric_variant>(
+							"handystats.internal.evicted_count",
+							internal::stats::evicted_count
+							)
+						);
+			}
+
+			if (cardinality_limited()) {
+				new_dump->insert(
+						std::pair<std::string, metrics::metric_variant>(
+							"handystats.internal.overflow_count",
+							internal::stats::overflow_count
+							)
+						);
+			}
+		}
+
+		// chrono
+		if (chrono::tsc_calibration_enabled()) {
+			new_dump->insert(
+					std::pair<std::string, metrics::metric_variant>(
+						"handystats.chrono.tsc_drift",
+						chrono::stats::tsc_drift
+						)
+					);
 		}
 
 		// message queue
@@ -177,6 +420,16 @@ create_dump()
 					);
 		}
 
+		// push export
+		if (push_export::enabled()) {
+			new_dump->insert(
+					std::pair<std::string, metrics::metric_variant>(
+						"handystats.push_export.dropped_count",
+						push_export::stats::dropped_count
+						)
+					);
+		}
+
 		// metrics_dump.dump_time will be added later
 	}
 
@@ -223,18 +476,48 @@ void update(const chrono::time_point& system_time, const chrono::time_point& int
 	}
 
 	if (system_time - dump_timestamp > config::metrics_dump_opts.interval) {
+		internal::evict_metrics(internal_time);
 		internal::update_metrics(internal_time);
 
 		internal::stats::update(system_time);
 		message_queue::stats::update(system_time);
+		chrono::stats::update(system_time);
+		push_export::stats::update(system_time);
 		stats::update(system_time);
 
-		auto new_dump = create_dump();
+		std::shared_ptr<dump_generations_type> new_generations(new dump_generations_type());
+		auto new_dump = create_dump(*new_generations);
+		const tags_filter new_tags_filter = snapshot_tags_filter(*new_dump);
+		auto new_rendered_dumps = render_dumps(*new_dump, new_tags_filter);
+		std::shared_ptr<const dump_removed_type> new_removed(new dump_removed_type(internal::removed_metrics.cbegin(), internal::removed_metrics.cend()));
+		auto binary_iter = new_rendered_dumps.find(config::dump_format::BINARY);
+		const std::shared_ptr<const std::string> binary_dump =
+			(binary_iter != new_rendered_dumps.end()) ? binary_iter->second : std::shared_ptr<const std::string>();
+
+		// published before dump, so dump being seen means it is exported
+		if (shm_export::enabled()) {
+			shm_export::publish(*new_dump, new_tags_filter, binary_dump.get(), internal::generation);
+		}
+
 		{
 			std::lock_guard<std::mutex> lock(dump_mutex);
 			dump = new_dump;
+			dump_tags_filter = new_tags_filter;
+			rendered_dumps.swap(new_rendered_dumps);
+
+			dump_generation = internal::generation;
+			dump_generations = new_generations;
+			dump_removed = new_removed;
+			dump_removed_since = internal::removed_metrics_since;
+		}
+
+		if (push_export::enabled()) {
+			push_export::submit(new_dump, new_tags_filter, binary_dump);
 		}
 
+		// events processed from now on belong to the next dump
+		++internal::generation;
+
 		dump_timestamp = system_time;
 	}
 }
@@ -247,6 +530,13 @@ void initialize() {
 
 		dump_timestamp = chrono::time_point();
 		dump = std::shared_ptr<const std::map<std::string, metrics::metric_variant>>(new std::map<std::string, metrics::metric_variant>());
+		dump_tags_filter = tags_filter();
+		rendered_dumps.clear();
+
+		dump_generation = 0;
+		dump_generations.reset(new dump_generations_type());
+		dump_removed.reset(new dump_removed_type());
+		dump_removed_since = 0;
 	}
 }
 
@@ -258,6 +548,13 @@ void finalize() {
 
 		dump_timestamp = chrono::time_point();
 		dump = std::shared_ptr<const std::map<std::string, metrics::metric_variant>>(new std::map<std::string, metrics::metric_variant>());
+		dump_tags_filter = tags_filter();
+		rendered_dumps.clear();
+
+		dump_generation = 0;
+		dump_generations.reset(new dump_generations_type());
+		dump_removed.reset(new dump_removed_type());
+		dump_removed_since = 0;
 	}
 }
 
@@ -266,3 +563,7 @@ void finalize() {
 const std::shared_ptr<const std::map<std::string, handystats::metrics::metric_variant>> HANDY_METRICS_DUMP() {
 	return handystats::metrics_dump::get_dump();
 }
+
+handystats::metrics_dump::delta HANDY_METRICS_DUMP_DELTA(const uint64_t& since) {
+	return handystats::metrics_dump::get_dump_delta(since);
+}
@@ -25,6 +25,7 @@
 #include <handystats/chrono.hpp>
 #include <handystats/metrics.hpp>
 #include <handystats/metrics/gauge.hpp>
+#include <handystats/metrics_dump.hpp>
 
 namespace handystats { namespace metrics_dump {
 
@@ -34,6 +35,12 @@ void update(const chrono::time_point& system_time, const chrono::time_point& int
 
 const std::shared_ptr<const std::map<std::string, metrics::metric_variant>> get_dump();
 
+delta get_dump_delta(const uint64_t& since);
+
+// dump rendered in given format (config::dump_format), nullptr for unknown format
+// formats not rendered on dump update are rendered by first reader and cached until next dump
+const std::shared_ptr<const std::string> get_rendered_dump(const int& format);
+
 void initialize();
 void finalize();
 
@@ -0,0 +1,299 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_OBJECT_POOL_IMPL_HPP_
+#define HANDYSTATS_OBJECT_POOL_IMPL_HPP_
+
+#include <new>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cstddef>
+#include <type_traits>
+
+namespace handystats {
+
+/*
+ * Pool of fixed-size slots for objects of type T allocated in chunks of ChunkSize slots.
+ *
+ * Objects allocated one after another are placed next to each other,
+ * freed slots are reused by subsequent allocations.
+ * Chunk is returned once all its slots are freed (except chunk allocations are currently served from),
+ * so pool shrinks back after peak.
+ * release() returns all chunks at once, objects should already be destroyed by then.
+ *
+ * Not thread-safe.
+ */
+template <typename T, size_t ChunkSize = 256>
+class object_pool {
+public:
+	object_pool()
+		: m_chunks()
+		, m_available()
+		, m_current(nullptr)
+		, m_size(0)
+	{}
+
+	~object_pool() {
+		release();
+	}
+
+	void* allocate() {
+		if (!m_current || m_current->full()) {
+			if (!m_available.empty()) {
+				m_current = m_available.back();
+				m_available.pop_back();
+				m_current->available_index = NOT_AVAILABLE;
+			}
+			else {
+				m_current = create_chunk();
+			}
+		}
+
+		++m_size;
+		return m_current->allocate();
+	}
+
+	void deallocate(void* ptr) {
+		slot* freed = static_cast<slot*>(ptr);
+		chunk* owner = find_chunk(freed);
+		owner->deallocate(freed);
+
+		--m_size;
+
+		if (owner == m_current) {
+			return;
+		}
+
+		if (owner->live == 0) {
+			destroy_chunk(owner);
+		}
+		else if (owner->available_index == NOT_AVAILABLE) {
+			owner->available_index = m_available.size();
+			m_available.push_back(owner);
+		}
+	}
+
+	template <typename... Args>
+	T* create(Args&&... args) {
+		void* ptr = allocate();
+		try {
+			return new (ptr) T(std::forward<Args>(args)...);
+		}
+		catch (...) {
+			deallocate(ptr);
+			throw;
+		}
+	}
+
+	void destroy(T* obj) {
+		obj->~T();
+		deallocate(obj);
+	}
+
+	void release() {
+		for (auto chunk_iter = m_chunks.begin(); chunk_iter != m_chunks.end(); ++chunk_iter) {
+			delete *chunk_iter;
+		}
+		m_chunks.clear();
+		m_available.clear();
+		m_current = nullptr;
+		m_size = 0;
+	}
+
+	// number of allocated slots
+	size_t size() const {
+		return m_size;
+	}
+
+	// number of chunks held by pool
+	size_t chunks() const {
+		return m_chunks.size();
+	}
+
+private:
+	union slot {
+		slot* next;
+		typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+	};
+
+	static const size_t NOT_AVAILABLE = size_t(-1);
+
+	struct chunk {
+		slot slots[ChunkSize];
+		// freed slots of this chunk
+		slot* free;
+		// slots handed out from the chunk's tail at least once
+		size_t used;
+		// number of allocated slots
+		size_t live;
+		// position in pool's list of available chunks or NOT_AVAILABLE
+		size_t available_index;
+
+		chunk()
+			: free(nullptr)
+			, used(0)
+			, live(0)
+			, available_index(NOT_AVAILABLE)
+		{}
+
+		bool full() const {
+			return live == ChunkSize;
+		}
+
+		slot* allocate() {
+			slot* allocated = free;
+			if (allocated) {
+				free = allocated->next;
+			}
+			else {
+				allocated = slots + used++;
+			}
+			++live;
+			return allocated;
+		}
+
+		void deallocate(slot* freed) {
+			freed->next = free;
+			free = freed;
+			--live;
+		}
+	};
+
+	chunk* create_chunk() {
+		chunk* created = new chunk();
+		m_chunks.insert(std::upper_bound(m_chunks.begin(), m_chunks.end(), created, std::less<chunk*>()), created);
+		return created;
+	}
+
+	void destroy_chunk(chunk* destroyed) {
+		if (destroyed->available_index != NOT_AVAILABLE) {
+			chunk* moved = m_available.back();
+			m_available[destroyed->available_index] = moved;
+			moved->available_index = destroyed->available_index;
+			m_available.pop_back();
+		}
+
+		m_chunks.erase(std::lower_bound(m_chunks.begin(), m_chunks.end(), destroyed, std::less<chunk*>()));
+		delete destroyed;
+	}
+
+	// chunks are ordered by address and start with their slots,
+	// so slot belongs to the last chunk placed before it
+	chunk* find_chunk(const slot* ptr) const {
+		auto chunk_iter = std::upper_bound(m_chunks.begin(), m_chunks.end(),
+				reinterpret_cast<chunk*>(const_cast<slot*>(ptr)), std::less<chunk*>()
+			);
+		return *(--chunk_iter);
+	}
+
+	object_pool(const object_pool&);
+	object_pool& operator= (const object_pool&);
+
+	// all chunks ordered by address
+	std::vector<chunk*> m_chunks;
+	// chunks with free slots except current one
+	std::vector<chunk*> m_available;
+	// chunk allocations are served from
+	chunk* m_current;
+	size_t m_size;
+};
+
+/*
+ * Stateless allocator placing single-object allocations (e.g. std::map nodes) into object_pool<T>.
+ * Pool is shared by all allocators of the same type and is never destroyed,
+ * so containers with static storage duration may be destructed in any order.
+ * Freed slots are reused, fully freed chunks are returned by the pool.
+ *
+ * Not thread-safe, containers using it should be accessed from single thread.
+ */
+template <typename T>
+class pool_allocator {
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <typename U>
+	struct rebind {
+		typedef pool_allocator<U> other;
+	};
+
+	pool_allocator() {}
+
+	template <typename U>
+	pool_allocator(const pool_allocator<U>&) {}
+
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+
+	pointer allocate(size_type n, const void* = 0) {
+		if (n == 1) {
+			return static_cast<pointer>(pool().allocate());
+		}
+		return static_cast<pointer>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(pointer ptr, size_type n) {
+		if (n == 1) {
+			pool().deallocate(ptr);
+		}
+		else {
+			::operator delete(ptr);
+		}
+	}
+
+	size_type max_size() const {
+		return std::numeric_limits<size_type>::max() / sizeof(T);
+	}
+
+	template <typename U, typename... Args>
+	void construct(U* ptr, Args&&... args) {
+		::new ((void*)ptr) U(std::forward<Args>(args)...);
+	}
+
+	template <typename U>
+	void destroy(U* ptr) {
+		ptr->~U();
+	}
+
+private:
+	static object_pool<T>& pool() {
+		static object_pool<T>* instance = new object_pool<T>();
+		return *instance;
+	}
+};
+
+template <typename T, typename U>
+inline bool operator== (const pool_allocator<T>&, const pool_allocator<U>&) {
+	return true;
+}
+
+template <typename T, typename U>
+inline bool operator!= (const pool_allocator<T>&, const pool_allocator<U>&) {
+	return false;
+}
+
+} // namespace handystats
+
+#endif // HANDYSTATS_OBJECT_POOL_IMPL_HPP_
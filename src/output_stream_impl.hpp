@@ -0,0 +1,113 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_OUTPUT_STREAM_IMPL_HPP_
+#define HANDYSTATS_OUTPUT_STREAM_IMPL_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+#include <errno.h>
+
+namespace handystats {
+
+/*
+ * Output streams used by dump serializers.
+ * Both satisfy rapidjson stream concept (Put(Ch) and Flush()).
+ */
+
+struct string_output_stream {
+	typedef char Ch;
+
+	string_output_stream(std::string& buffer)
+		: buffer(buffer)
+	{}
+
+	void Put(Ch c) {
+		buffer.push_back(c);
+	}
+
+	void Put(const Ch* str, const size_t& len) {
+		buffer.append(str, len);
+	}
+
+	void Flush() {
+	}
+
+	std::string& buffer;
+};
+
+struct fd_output_stream {
+	typedef char Ch;
+
+	static const size_t BUFFER_SIZE = 16 * 1024;
+
+	fd_output_stream(const int& fd)
+		: fd(fd)
+		, size(0)
+		, failed(false)
+	{}
+
+	void Put(Ch c) {
+		if (size == BUFFER_SIZE) {
+			Flush();
+		}
+		buffer[size++] = c;
+	}
+
+	void Put(const Ch* str, size_t len) {
+		while (len > 0) {
+			if (size == BUFFER_SIZE) {
+				Flush();
+			}
+			const size_t chunk = (len < BUFFER_SIZE - size) ? len : BUFFER_SIZE - size;
+			memcpy(buffer + size, str, chunk);
+			size += chunk;
+			str += chunk;
+			len -= chunk;
+		}
+	}
+
+	// on write error stream turns into failed state and discards further output
+	void Flush() {
+		size_t written = 0;
+		while (!failed && written < size) {
+			const ssize_t res = ::write(fd, buffer + written, size - written);
+			if (res < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				failed = true;
+			}
+			else {
+				written += res;
+			}
+		}
+		size = 0;
+	}
+
+	const int fd;
+	char buffer[BUFFER_SIZE];
+	size_t size;
+	bool failed;
+};
+
+} // namespace handystats
+
+#endif // HANDYSTATS_OUTPUT_STREAM_IMPL_HPP_
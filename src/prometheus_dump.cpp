@@ -0,0 +1,561 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cinttypes>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <handystats/prometheus_dump.hpp>
+#include <handystats/metrics/gauge.hpp>
+#include <handystats/metrics/counter.hpp>
+#include <handystats/metrics/timer.hpp>
+#include <handystats/metrics/attribute.hpp>
+
+#include "output_stream_impl.hpp"
+#include "config_impl.hpp"
+#include "metrics_dump_impl.hpp"
+#include "dump_filter_impl.hpp"
+
+namespace handystats { namespace prometheus {
+
+namespace {
+
+const double SUMMARY_QUANTILES[] = {0.25, 0.50, 0.75, 0.90, 0.95};
+
+// statistics exposed as separate gauges <name>_<suffix>
+const std::pair<statistics::tag::type, const char*> GAUGE_STATISTICS[] = {
+	std::make_pair(statistics::tag::min, "_min"),
+	std::make_pair(statistics::tag::max, "_max"),
+	std::make_pair(statistics::tag::count, "_count"),
+	std::make_pair(statistics::tag::sum, "_sum"),
+	std::make_pair(statistics::tag::avg, "_avg"),
+	std::make_pair(statistics::tag::moving_count, "_moving_count"),
+	std::make_pair(statistics::tag::moving_sum, "_moving_sum"),
+	std::make_pair(statistics::tag::moving_avg, "_moving_avg"),
+	std::make_pair(statistics::tag::timestamp, "_timestamp"),
+	std::make_pair(statistics::tag::rate, "_rate"),
+	std::make_pair(statistics::tag::entropy, "_entropy"),
+};
+
+const size_t GAUGE_STATISTICS_COUNT = sizeof(GAUGE_STATISTICS) / sizeof(GAUGE_STATISTICS[0]);
+
+// suffixes of families and samples other than GAUGE_STATISTICS
+const char* const OTHER_SUFFIXES[] = {
+	"", "_value", "_summary", "_histogram", "_histogram_bucket", "_histogram_sum", "_histogram_count", "_info"
+};
+
+/*
+ * Suffixes metric could be exposed with, indexed as GAUGE_STATISTICS followed by OTHER_SUFFIXES.
+ * Set of suffixes of a metric is kept as bit mask.
+ */
+const size_t NO_SUFFIX = GAUGE_STATISTICS_COUNT;
+const size_t VALUE_SUFFIX = GAUGE_STATISTICS_COUNT + 1;
+const size_t SUMMARY_SUFFIX = GAUGE_STATISTICS_COUNT + 2;
+const size_t HISTOGRAM_SUFFIX = GAUGE_STATISTICS_COUNT + 3;
+const size_t INFO_SUFFIX = GAUGE_STATISTICS_COUNT + 7;
+const size_t SUFFIXES_COUNT = GAUGE_STATISTICS_COUNT + sizeof(OTHER_SUFFIXES) / sizeof(OTHER_SUFFIXES[0]);
+
+inline const char* exposed_suffix(const size_t& index) {
+	return (index < GAUGE_STATISTICS_COUNT) ? GAUGE_STATISTICS[index].second : OTHER_SUFFIXES[index - GAUGE_STATISTICS_COUNT];
+}
+
+inline uint32_t suffix_bit(const size_t& index) {
+	return uint32_t(1) << index;
+}
+
+// replaces characters not allowed in metric names with '_'
+void sanitize_name(const std::string& name, std::string& sanitized) {
+	sanitized.clear();
+	sanitized.reserve(name.size() + 1);
+
+	if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+		sanitized.push_back('_');
+	}
+
+	for (size_t index = 0; index < name.size(); ++index) {
+		const char c = name[index];
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':') {
+			sanitized.push_back(c);
+		}
+		else {
+			sanitized.push_back('_');
+		}
+	}
+}
+
+// suffixes of families and samples metric is written with, follows writer's write_metric
+uint32_t exposed_suffixes(const metrics::metric_variant& metric, const statistics::tag::type& tags_filter) {
+	const statistics* values = nullptr;
+	switch (metric.which()) {
+		case metrics::metric_index::GAUGE:
+			values = &boost::get<metrics::gauge>(metric).values();
+			break;
+		case metrics::metric_index::COUNTER:
+			values = &boost::get<metrics::counter>(metric).values();
+			break;
+		case metrics::metric_index::TIMER:
+			values = &boost::get<metrics::timer>(metric).values();
+			break;
+		case metrics::metric_index::ATTRIBUTE:
+			{
+				const auto& value = boost::get<metrics::attribute>(metric).value();
+				return suffix_bit(value.which() == metrics::attribute::value_index::STRING ? INFO_SUFFIX : NO_SUFFIX);
+			}
+		default:
+			return 0;
+	}
+
+	const statistics::tag::type tags = values->tags() & tags_filter;
+	uint32_t suffixes = 0;
+
+	if (metric.which() == metrics::metric_index::TIMER) {
+		if (tags & (statistics::tag::quantile | statistics::tag::sum | statistics::tag::count)) {
+			suffixes |= suffix_bit(NO_SUFFIX);
+		}
+		if (tags & statistics::tag::value) {
+			suffixes |= suffix_bit(VALUE_SUFFIX);
+		}
+	}
+	else {
+		if (tags & statistics::tag::value) {
+			suffixes |= suffix_bit(NO_SUFFIX);
+		}
+		if (tags & statistics::tag::quantile) {
+			suffixes |= suffix_bit(SUMMARY_SUFFIX);
+		}
+	}
+
+	if (tags & statistics::tag::histogram) {
+		// _histogram family with _bucket, _sum and _count samples
+		for (size_t index = HISTOGRAM_SUFFIX; index < HISTOGRAM_SUFFIX + 4; ++index) {
+			suffixes |= suffix_bit(index);
+		}
+	}
+
+	// summary's _sum and _count samples have the same names as sum and count gauges
+	for (size_t index = 0; index < GAUGE_STATISTICS_COUNT; ++index) {
+		if (tags & GAUGE_STATISTICS[index].first) {
+			suffixes |= suffix_bit(index);
+		}
+	}
+
+	return suffixes;
+}
+
+// sanitized names of exposed metrics with suffixes they are exposed with
+typedef std::unordered_map<std::string, uint32_t> exposed_names_type;
+
+/*
+ * Checks whether any of metric's names is already exposed by previous metrics.
+ * Exposed name is other metric's name followed by one of its suffixes,
+ * so each name is split at every known suffix it ends with.
+ */
+bool collides(
+		const exposed_names_type& exposed_names,
+		const std::string& name, const uint32_t& suffixes,
+		std::string& full_name, std::string& other_name
+	)
+{
+	for (size_t index = 0; index < SUFFIXES_COUNT; ++index) {
+		if (!(suffixes & suffix_bit(index))) {
+			continue;
+		}
+
+		full_name.assign(name).append(exposed_suffix(index));
+
+		for (size_t other_index = 0; other_index < SUFFIXES_COUNT; ++other_index) {
+			const char* other_suffix = exposed_suffix(other_index);
+			const size_t other_suffix_size = strlen(other_suffix);
+			if (other_suffix_size >= full_name.size() ||
+					full_name.compare(full_name.size() - other_suffix_size, other_suffix_size, other_suffix) != 0)
+			{
+				continue;
+			}
+
+			other_name.assign(full_name, 0, full_name.size() - other_suffix_size);
+			auto exposed_iter = exposed_names.find(other_name);
+			if (exposed_iter != exposed_names.end() && (exposed_iter->second & suffix_bit(other_index))) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+template <typename OutputStream>
+class writer {
+public:
+	writer(OutputStream& stream)
+		: m_stream(stream)
+	{}
+
+	// name is sanitized already
+	void write_metric(const std::string& name, const metrics::metric_variant& metric, const statistics::tag::type& tags_filter) {
+		m_name.assign(name);
+
+		switch (metric.which()) {
+			case metrics::metric_index::GAUGE:
+				write_statistics(boost::get<metrics::gauge>(metric).values(), "gauge", tags_filter);
+				break;
+			case metrics::metric_index::COUNTER:
+				write_statistics(boost::get<metrics::counter>(metric).values(), "gauge", tags_filter);
+				break;
+			case metrics::metric_index::TIMER:
+				write_statistics(boost::get<metrics::timer>(metric).values(), "summary", tags_filter);
+				break;
+			case metrics::metric_index::ATTRIBUTE:
+				write_attribute(boost::get<metrics::attribute>(metric));
+				break;
+		}
+	}
+
+private:
+	void put(const char* str) {
+		m_stream.Put(str, strlen(str));
+	}
+
+	void put(const char* str, const size_t& len) {
+		m_stream.Put(str, len);
+	}
+
+	void put_number(const double& value) {
+		if (std::isnan(value)) {
+			put("NaN", 3);
+			return;
+		}
+		if (std::isinf(value)) {
+			if (value > 0) {
+				put("+Inf", 4);
+			}
+			else {
+				put("-Inf", 4);
+			}
+			return;
+		}
+
+		// shortest of two representations that reads back exactly
+		int len = snprintf(m_number, sizeof(m_number), "%.15g", value);
+		if (strtod(m_number, nullptr) != value) {
+			len = snprintf(m_number, sizeof(m_number), "%.17g", value);
+		}
+		put(m_number, len);
+	}
+
+	void put_number(const uint64_t& value) {
+		const int len = snprintf(m_number, sizeof(m_number), "%" PRIu64, value);
+		put(m_number, len);
+	}
+
+	void put_name(const char* suffix) {
+		put(m_name.c_str(), m_name.size());
+		put(suffix);
+	}
+
+	void put_type(const char* suffix, const char* type) {
+		put("# TYPE ", 7);
+		put_name(suffix);
+		m_stream.Put(' ');
+		put(type);
+		m_stream.Put('\n');
+	}
+
+	template <typename Value>
+	void put_sample(const char* suffix, const Value& value) {
+		put_name(suffix);
+		m_stream.Put(' ');
+		put_number(value);
+		m_stream.Put('\n');
+	}
+
+	template <typename Value>
+	void put_sample(const char* suffix, const char* label, const double& label_value, const Value& value) {
+		put_name(suffix);
+		m_stream.Put('{');
+		put(label);
+		put("=\"", 2);
+		put_number(label_value);
+		put("\"} ", 3);
+		put_number(value);
+		m_stream.Put('\n');
+	}
+
+	void put_label_value(const std::string& value) {
+		for (size_t index = 0; index < value.size(); ++index) {
+			switch (value[index]) {
+				case '\\':
+					put("\\\\", 2);
+					break;
+				case '"':
+					put("\\\"", 2);
+					break;
+				case '\n':
+					put("\\n", 2);
+					break;
+				default:
+					m_stream.Put(value[index]);
+			}
+		}
+	}
+
+	double statistics_value(const statistics& values, const statistics::tag::type& tag) {
+		switch (tag) {
+			case statistics::tag::value:
+				return values.get<statistics::tag::value>();
+			case statistics::tag::min:
+				return values.get<statistics::tag::min>();
+			case statistics::tag::max:
+				return values.get<statistics::tag::max>();
+			case statistics::tag::count:
+				return values.get<statistics::tag::count>();
+			case statistics::tag::sum:
+				return values.get<statistics::tag::sum>();
+			case statistics::tag::avg:
+				return values.get<statistics::tag::avg>();
+			case statistics::tag::moving_count:
+				return values.get<statistics::tag::moving_count>();
+			case statistics::tag::moving_sum:
+				return values.get<statistics::tag::moving_sum>();
+			case statistics::tag::moving_avg:
+				return values.get<statistics::tag::moving_avg>();
+			case statistics::tag::timestamp:
+				{
+					const chrono::time_point system_timestamp =
+						chrono::time_point::convert_to(chrono::clock_type::SYSTEM, values.get<statistics::tag::timestamp>());
+					return chrono::duration::convert_to(chrono::time_unit::MSEC, system_timestamp.time_since_epoch()).count();
+				}
+			case statistics::tag::rate:
+				return values.get<statistics::tag::rate>();
+			case statistics::tag::entropy:
+				return values.get<statistics::tag::entropy>();
+			default:
+				return 0;
+		}
+	}
+
+	void write_summary(const statistics& values, const char* suffix, const bool& with_sum_count, const statistics::tag::type& tags) {
+		put_type(suffix, "summary");
+
+		if (tags & statistics::tag::quantile) {
+			const auto quantile = values.get<statistics::tag::quantile>();
+			for (size_t index = 0; index < sizeof(SUMMARY_QUANTILES) / sizeof(SUMMARY_QUANTILES[0]); ++index) {
+				put_sample(suffix, "quantile", SUMMARY_QUANTILES[index], quantile.at(SUMMARY_QUANTILES[index]));
+			}
+		}
+
+		if (with_sum_count) {
+			m_suffix.assign(suffix);
+			if (tags & statistics::tag::sum) {
+				put_sample((m_suffix + "_sum").c_str(), values.get<statistics::tag::sum>());
+			}
+			if (tags & statistics::tag::count) {
+				put_sample((m_suffix + "_count").c_str(), uint64_t(values.get<statistics::tag::count>()));
+			}
+		}
+	}
+
+	// bucket upper bounds are placed in the middle between adjacent bin centers
+	void write_histogram(const statistics& values) {
+		const auto& histogram = values.get<statistics::tag::histogram>();
+
+		put_type("_histogram", "histogram");
+
+		double cumulative_count = 0;
+		double sum = 0;
+		for (size_t index = 0; index < histogram.size(); ++index) {
+			const double center = std::get<statistics::BIN_CENTER>(histogram[index]);
+			const double count = std::get<statistics::BIN_COUNT>(histogram[index]);
+
+			cumulative_count += count;
+			sum += center * count;
+
+			if (index + 1 < histogram.size()) {
+				const double bound = (center + std::get<statistics::BIN_CENTER>(histogram[index + 1])) / 2;
+				put_sample("_histogram_bucket", "le", bound, cumulative_count);
+			}
+		}
+		put_name("_histogram_bucket");
+		put("{le=\"+Inf\"} ", 12);
+		put_number(cumulative_count);
+		m_stream.Put('\n');
+
+		put_sample("_histogram_sum", sum);
+		put_sample("_histogram_count", cumulative_count);
+	}
+
+	void write_statistics(const statistics& values, const char* type, const statistics::tag::type& tags_filter) {
+		const statistics::tag::type tags = values.tags() & tags_filter;
+		const bool is_summary = strcmp(type, "summary") == 0;
+
+		if (is_summary) {
+			if (tags & (statistics::tag::quantile | statistics::tag::sum | statistics::tag::count)) {
+				write_summary(values, "", true, tags);
+			}
+			if (tags & statistics::tag::value) {
+				put_type("_value", "gauge");
+				put_sample("_value", values.get<statistics::tag::value>());
+			}
+		}
+		else {
+			if (tags & statistics::tag::value) {
+				put_type("", type);
+				put_sample("", values.get<statistics::tag::value>());
+			}
+			if (tags & statistics::tag::quantile) {
+				write_summary(values, "_summary", false, tags);
+			}
+		}
+
+		if (tags & statistics::tag::histogram) {
+			write_histogram(values);
+		}
+
+		for (size_t index = 0; index < sizeof(GAUGE_STATISTICS) / sizeof(GAUGE_STATISTICS[0]); ++index) {
+			const statistics::tag::type& tag = GAUGE_STATISTICS[index].first;
+			const char* suffix = GAUGE_STATISTICS[index].second;
+
+			// already exposed as part of summary
+			if (is_summary && (tag == statistics::tag::sum || tag == statistics::tag::count)) {
+				continue;
+			}
+
+			if (tags & tag) {
+				put_type(suffix, "gauge");
+				put_sample(suffix, statistics_value(values, tag));
+			}
+		}
+	}
+
+	void write_attribute(const metrics::attribute& attribute) {
+		const auto& value = attribute.value();
+
+		if (value.which() == metrics::attribute::value_index::STRING) {
+			put_type("_info", "gauge");
+			put_name("_info");
+			put("{value=\"", 8);
+			put_label_value(boost::get<std::string>(value));
+			put("\"} 1\n", 5);
+			return;
+		}
+
+		put_type("", "gauge");
+		switch (value.which()) {
+			case metrics::attribute::value_index::BOOL:
+				put_sample("", uint64_t(boost::get<bool>(value) ? 1 : 0));
+				break;
+			case metrics::attribute::value_index::INT:
+				put_sample("", double(boost::get<int>(value)));
+				break;
+			case metrics::attribute::value_index::UINT:
+				put_sample("", uint64_t(boost::get<unsigned>(value)));
+				break;
+			case metrics::attribute::value_index::INT64:
+				put_sample("", double(boost::get<int64_t>(value)));
+				break;
+			case metrics::attribute::value_index::UINT64:
+				put_sample("", boost::get<uint64_t>(value));
+				break;
+			case metrics::attribute::value_index::DOUBLE:
+				put_sample("", boost::get<double>(value));
+				break;
+		}
+	}
+
+	OutputStream& m_stream;
+	std::string m_name;
+	std::string m_suffix;
+	char m_number[64];
+};
+
+/*
+ * Writes metrics skipping ones with names already exposed by previous metrics.
+ * Collisions are detected from sanitized names and exposed suffixes, so skipped metric writes nothing.
+ */
+template <typename OutputStream>
+void write(
+		const std::map<std::string, metrics::metric_variant>& metrics_map, OutputStream& stream,
+		const metrics_dump::tags_filter& tags_filter
+	)
+{
+	exposed_names_type exposed_names;
+	std::string name, full_name, other_name;
+
+	writer<OutputStream> metrics_writer(stream);
+
+	for (auto metric_iter = metrics_map.cbegin(); metric_iter != metrics_map.cend(); ++metric_iter) {
+		const statistics::tag::type tags = tags_filter(metric_iter->first);
+
+		sanitize_name(metric_iter->first, name);
+		const uint32_t suffixes = exposed_suffixes(metric_iter->second, tags);
+
+		if (collides(exposed_names, name, suffixes, full_name, other_name)) {
+			continue;
+		}
+
+		metrics_writer.write_metric(name, metric_iter->second, tags);
+		exposed_names[name] |= suffixes;
+	}
+}
+
+} // unnamed namespace
+
+std::string to_string(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map) {
+	std::string buffer;
+	write_to_string(metrics_map, buffer);
+	return buffer;
+}
+
+void write_to_string(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, std::string& buffer) {
+	string_output_stream stream(buffer);
+	write(metrics_map, stream, metrics_dump::tags_filter());
+}
+
+void write_to_string(
+		const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, std::string& buffer,
+		const metrics_dump::tags_filter& tags_filter
+	)
+{
+	string_output_stream stream(buffer);
+	write(metrics_map, stream, tags_filter);
+}
+
+bool write_to_fd(const std::map<std::string, handystats::metrics::metric_variant>& metrics_map, const int& fd) {
+	fd_output_stream stream(fd);
+	write(metrics_map, stream, metrics_dump::tags_filter());
+	stream.Flush();
+	return !stream.failed;
+}
+
+}} // namespace handystats::prometheus
+
+std::shared_ptr<const std::string> HANDY_PROMETHEUS_DUMP_SHARED() {
+	auto rendered_dump = handystats::metrics_dump::get_rendered_dump(handystats::config::dump_format::PROMETHEUS);
+	if (rendered_dump) {
+		return rendered_dump;
+	}
+
+	return std::shared_ptr<const std::string>(new std::string(handystats::prometheus::to_string(*HANDY_METRICS_DUMP())));
+}
+
+std::string HANDY_PROMETHEUS_DUMP() {
+	return *HANDY_PROMETHEUS_DUMP_SHARED();
+}
@@ -0,0 +1,528 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <handystats/binary_dump.hpp>
+#include <handystats/metrics/gauge.hpp>
+#include <handystats/metrics/counter.hpp>
+#include <handystats/metrics/timer.hpp>
+#include <handystats/metrics/attribute.hpp>
+
+#include "config_impl.hpp"
+
+#include "push_export_impl.hpp"
+
+namespace handystats { namespace push_export {
+
+namespace {
+
+enum class transport_type {
+	NONE,
+	UNIX,
+	UDP
+};
+
+const char UNIX_PREFIX[] = "unix:";
+const char UDP_PREFIX[] = "udp:";
+
+// exporter thread waits this long for new dump while there is unsent data
+const std::chrono::milliseconds FLUSH_INTERVAL(10);
+// and this long while idle
+const std::chrono::milliseconds IDLE_INTERVAL(100);
+
+std::thread exporter_thread;
+std::mutex exporter_mutex;
+std::condition_variable exporter_cv;
+bool exporter_stop = false;
+bool exporter_running = false;
+
+// single handoff slot, guarded by exporter_mutex
+std::shared_ptr<const std::map<std::string, metrics::metric_variant>> pending_dump;
+metrics_dump::tags_filter pending_tags_filter;
+std::shared_ptr<const std::string> pending_binary_dump;
+
+std::atomic<uint64_t> dropped(0);
+
+class exporter {
+public:
+	exporter()
+		: m_transport(transport_type::NONE)
+		, m_fd(-1)
+		, m_address()
+		, m_address_size(0)
+		, m_buffer()
+		, m_sent(0)
+		, m_frame()
+		, m_datagram_failed(false)
+	{}
+
+	~exporter() {
+		disconnect();
+	}
+
+	bool configure(const std::string& address) {
+		if (address.compare(0, sizeof(UNIX_PREFIX) - 1, UNIX_PREFIX) == 0) {
+			const std::string path = address.substr(sizeof(UNIX_PREFIX) - 1);
+			sockaddr_un* unix_address = reinterpret_cast<sockaddr_un*>(&m_address);
+			if (path.empty() || path.size() >= sizeof(unix_address->sun_path)) {
+				return false;
+			}
+			memset(&m_address, 0, sizeof(m_address));
+			unix_address->sun_family = AF_UNIX;
+			memcpy(unix_address->sun_path, path.c_str(), path.size() + 1);
+			m_address_size = sizeof(sockaddr_un);
+			m_transport = transport_type::UNIX;
+			return true;
+		}
+
+		if (address.compare(0, sizeof(UDP_PREFIX) - 1, UDP_PREFIX) == 0) {
+			const std::string host_port = address.substr(sizeof(UDP_PREFIX) - 1);
+			const size_t port_pos = host_port.rfind(':');
+			if (port_pos == std::string::npos) {
+				return false;
+			}
+			const std::string host = host_port.substr(0, port_pos);
+			const std::string port = host_port.substr(port_pos + 1);
+
+			addrinfo hints;
+			memset(&hints, 0, sizeof(hints));
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_DGRAM;
+
+			addrinfo* result = nullptr;
+			if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || !result) {
+				return false;
+			}
+			memcpy(&m_address, result->ai_addr, result->ai_addrlen);
+			m_address_size = result->ai_addrlen;
+			freeaddrinfo(result);
+
+			m_transport = transport_type::UDP;
+			return true;
+		}
+
+		return false;
+	}
+
+	void send(
+			const std::map<std::string, metrics::metric_variant>& dump,
+			const metrics_dump::tags_filter& tags_filter,
+			const std::shared_ptr<const std::string>& binary_dump
+		)
+	{
+		switch (m_transport) {
+			case transport_type::UNIX:
+				send_frame(dump, tags_filter, binary_dump);
+				break;
+			case transport_type::UDP:
+				send_datagrams(dump, tags_filter);
+				break;
+			default:
+				break;
+		}
+	}
+
+	bool has_unsent() const {
+		return m_sent < m_buffer.size();
+	}
+
+	// sends as much of buffered data as socket accepts without blocking
+	void flush() {
+		while (has_unsent() && m_fd >= 0) {
+			const ssize_t res = ::send(m_fd, m_buffer.data() + m_sent, m_buffer.size() - m_sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+			if (res > 0) {
+				m_sent += res;
+			}
+			else if (res < 0 && errno == EINTR) {
+				continue;
+			}
+			else if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				break;
+			}
+			else {
+				// connection is lost, partially sent frame is useless
+				disconnect();
+				if (has_unsent()) {
+					dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+				m_buffer.clear();
+				m_sent = 0;
+			}
+		}
+
+		if (!has_unsent()) {
+			m_buffer.clear();
+			m_sent = 0;
+		}
+		else if (m_sent > m_buffer.size() / 2) {
+			m_buffer.erase(0, m_sent);
+			m_sent = 0;
+		}
+	}
+
+private:
+	bool connect() {
+		if (m_fd >= 0) {
+			return true;
+		}
+
+		const int domain = reinterpret_cast<const sockaddr*>(&m_address)->sa_family;
+		const int type = (m_transport == transport_type::UNIX) ? SOCK_STREAM : SOCK_DGRAM;
+
+		m_fd = socket(domain, type, 0);
+		if (m_fd < 0) {
+			return false;
+		}
+
+		fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+
+		if (::connect(m_fd, reinterpret_cast<const sockaddr*>(&m_address), m_address_size) != 0 && errno != EINPROGRESS) {
+			disconnect();
+			return false;
+		}
+
+		return true;
+	}
+
+	void disconnect() {
+		if (m_fd >= 0) {
+			close(m_fd);
+			m_fd = -1;
+		}
+	}
+
+	void send_frame(
+			const std::map<std::string, metrics::metric_variant>& dump,
+			const metrics_dump::tags_filter& tags_filter,
+			const std::shared_ptr<const std::string>& binary_dump
+		)
+	{
+		if (!connect()) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		if (binary_dump) {
+			m_frame.assign(*binary_dump);
+		}
+		else {
+			m_frame.clear();
+			binary::write_to_string(dump, m_frame, tags_filter);
+		}
+
+		// unsent data including this frame never exceeds buffer size
+		if (m_buffer.size() - m_sent + m_frame.size() + 4 > config::push_export_opts.buffer_size) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		const uint32_t size = m_frame.size();
+		for (size_t index = 0; index < 4; ++index) {
+			m_buffer.push_back(char(size >> (8 * index)));
+		}
+		m_buffer.append(m_frame);
+
+		flush();
+	}
+
+	void append_line(const std::string& name, const double& value, const char* type) {
+		char value_buffer[64];
+		const int value_size = snprintf(value_buffer, sizeof(value_buffer), "%.15g", value);
+
+		const size_t line_size = name.size() + 1 + value_size + 1 + strlen(type) + 1;
+		if (!m_frame.empty() && m_frame.size() + line_size > config::push_export_opts.max_datagram_size) {
+			send_datagram();
+		}
+
+		for (size_t index = 0; index < name.size(); ++index) {
+			const char c = name[index];
+			m_frame.push_back((c == ':' || c == '|' || c == '@' || isspace(c)) ? '_' : c);
+		}
+		m_frame.push_back(':');
+		m_frame.append(value_buffer, value_size);
+		m_frame.push_back('|');
+		m_frame.append(type);
+		m_frame.push_back('\n');
+	}
+
+	void send_datagram() {
+		if (m_frame.empty() || m_datagram_failed) {
+			m_frame.clear();
+			return;
+		}
+
+		// trailing newline is not sent
+		const ssize_t res = ::send(m_fd, m_frame.data(), m_frame.size() - 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (res < 0) {
+			m_datagram_failed = true;
+		}
+		m_frame.clear();
+	}
+
+	// value is enabled for metric and is not excluded by dump-filter
+	static bool value_selected(const statistics& values, const statistics::tag::type& tags) {
+		return values.enabled(statistics::tag::value) && (tags & statistics::tag::value);
+	}
+
+	void send_datagrams(const std::map<std::string, metrics::metric_variant>& dump, const metrics_dump::tags_filter& tags_filter) {
+		if (!connect()) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		static const double TIMER_UNITS_PER_MSEC =
+			chrono::duration::convert_to(metrics::timer::value_unit, chrono::duration(1, chrono::time_unit::MSEC)).count();
+
+		m_frame.clear();
+		m_datagram_failed = false;
+
+		for (auto metric_iter = dump.cbegin(); metric_iter != dump.cend(); ++metric_iter) {
+			const std::string& name = metric_iter->first;
+			switch (metric_iter->second.which()) {
+				case metrics::metric_index::GAUGE:
+					{
+						const auto& values = boost::get<metrics::gauge>(metric_iter->second).values();
+						if (value_selected(values, tags_filter(name))) {
+							append_line(name, values.get<statistics::tag::value>(), "g");
+						}
+						break;
+					}
+				case metrics::metric_index::COUNTER:
+					{
+						const auto& values = boost::get<metrics::counter>(metric_iter->second).values();
+						if (value_selected(values, tags_filter(name))) {
+							append_line(name, values.get<statistics::tag::value>(), "g");
+						}
+						break;
+					}
+				case metrics::metric_index::TIMER:
+					{
+						const auto& values = boost::get<metrics::timer>(metric_iter->second).values();
+						if (value_selected(values, tags_filter(name))) {
+							append_line(name, values.get<statistics::tag::value>() / TIMER_UNITS_PER_MSEC, "ms");
+						}
+						break;
+					}
+				case metrics::metric_index::ATTRIBUTE:
+					{
+						const auto& value = boost::get<metrics::attribute>(metric_iter->second).value();
+						switch (value.which()) {
+							case metrics::attribute::value_index::BOOL:
+								append_line(name, boost::get<bool>(value) ? 1 : 0, "g");
+								break;
+							case metrics::attribute::value_index::INT:
+								append_line(name, boost::get<int>(value), "g");
+								break;
+							case metrics::attribute::value_index::UINT:
+								append_line(name, boost::get<unsigned>(value), "g");
+								break;
+							case metrics::attribute::value_index::INT64:
+								append_line(name, boost::get<int64_t>(value), "g");
+								break;
+							case metrics::attribute::value_index::UINT64:
+								append_line(name, boost::get<uint64_t>(value), "g");
+								break;
+							case metrics::attribute::value_index::DOUBLE:
+								append_line(name, boost::get<double>(value), "g");
+								break;
+							default:
+								break;
+						}
+						break;
+					}
+			}
+		}
+		send_datagram();
+
+		if (m_datagram_failed) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	transport_type m_transport;
+	int m_fd;
+	sockaddr_storage m_address;
+	socklen_t m_address_size;
+
+	// unsent data of unix stream
+	std::string m_buffer;
+	size_t m_sent;
+
+	// frame or datagram being built
+	std::string m_frame;
+	bool m_datagram_failed;
+};
+
+void run_exporter(std::shared_ptr<exporter> exp) {
+	while (true) {
+		std::shared_ptr<const std::map<std::string, metrics::metric_variant>> dump;
+		metrics_dump::tags_filter tags_filter;
+		std::shared_ptr<const std::string> binary_dump;
+		{
+			std::unique_lock<std::mutex> lock(exporter_mutex);
+			exporter_cv.wait_for(
+					lock,
+					exp->has_unsent() ? FLUSH_INTERVAL : IDLE_INTERVAL,
+					[] () { return exporter_stop || pending_dump; }
+				);
+
+			if (exporter_stop) {
+				break;
+			}
+
+			dump.swap(pending_dump);
+			tags_filter = pending_tags_filter;
+			pending_tags_filter = metrics_dump::tags_filter();
+			binary_dump.swap(pending_binary_dump);
+		}
+
+		if (dump) {
+			exp->send(*dump, tags_filter, binary_dump);
+		}
+		else {
+			exp->flush();
+		}
+	}
+
+	// last attempt to deliver buffered data
+	exp->flush();
+}
+
+} // unnamed namespace
+
+bool enabled() {
+	return exporter_running;
+}
+
+void submit(
+		const std::shared_ptr<const std::map<std::string, metrics::metric_variant>>& dump,
+		const metrics_dump::tags_filter& tags_filter,
+		const std::shared_ptr<const std::string>& binary_dump
+	)
+{
+	if (!enabled()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(exporter_mutex);
+		if (pending_dump) {
+			// exporter is still busy with previous dump
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+		pending_dump = dump;
+		pending_tags_filter = tags_filter;
+		pending_binary_dump = binary_dump;
+	}
+	exporter_cv.notify_one();
+}
+
+uint64_t dropped_count() {
+	return dropped.load(std::memory_order_relaxed);
+}
+
+
+namespace stats {
+
+metrics::counter dropped_count;
+
+// drops already accounted in dropped_count
+static uint64_t counted_drops = 0;
+
+void update(const chrono::time_point& timestamp) {
+	const uint64_t drops = push_export::dropped_count();
+	if (drops > counted_drops) {
+		dropped_count.increment(drops - counted_drops, timestamp);
+		counted_drops = drops;
+	}
+	dropped_count.update_statistics(timestamp);
+}
+
+static void reset() {
+	config::metrics::counter dropped_count_opts;
+	dropped_count_opts.values.tags = statistics::tag::value;
+
+	dropped_count = metrics::counter(dropped_count_opts);
+	counted_drops = 0;
+}
+
+void initialize() {
+	reset();
+}
+
+void finalize() {
+	reset();
+}
+
+} // namespace stats
+
+
+void initialize() {
+	finalize();
+
+	stats::initialize();
+
+	if (config::push_export_opts.address.empty()) {
+		return;
+	}
+
+	std::shared_ptr<exporter> exp(new exporter());
+	if (!exp->configure(config::push_export_opts.address)) {
+		return;
+	}
+
+	exporter_stop = false;
+	exporter_running = true;
+	exporter_thread = std::thread(run_exporter, exp);
+}
+
+void finalize() {
+	{
+		std::lock_guard<std::mutex> lock(exporter_mutex);
+		exporter_stop = true;
+	}
+	exporter_cv.notify_one();
+
+	if (exporter_thread.joinable()) {
+		exporter_thread.join();
+	}
+
+	exporter_running = false;
+	pending_dump.reset();
+	pending_tags_filter = metrics_dump::tags_filter();
+	pending_binary_dump.reset();
+	dropped.store(0, std::memory_order_relaxed);
+
+	stats::finalize();
+}
+
+}} // namespace handystats::push_export
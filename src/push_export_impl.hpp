@@ -0,0 +1,78 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_PUSH_EXPORT_IMPL_HPP_
+#define HANDYSTATS_PUSH_EXPORT_IMPL_HPP_
+
+#include <string>
+#include <memory>
+#include <map>
+#include <cstdint>
+
+#include <handystats/chrono.hpp>
+#include <handystats/metrics.hpp>
+#include <handystats/metrics/counter.hpp>
+
+#include "dump_filter_impl.hpp"
+
+/*
+ * Push exporter.
+ *
+ * Dumps are handed over to exporter thread, which sends them to configured address:
+ *   unix:<path> -- stream socket, each dump is sent as frame of
+ *                  <payload size : 4 bytes little-endian> <binary dump>
+ *   udp:<host>:<port> -- statsd-like lines batched into datagrams:
+ *                  <name>:<value>|g for gauges, counters and numeric attributes,
+ *                  <name>:<value in msec>|ms for timers
+ *
+ * Sockets are non-blocking, unsent data is kept in bounded buffer.
+ * Dump is dropped if it does not fit into buffer (along with unsent data) or if exporter has not picked previous dump yet,
+ * so slow collector never stalls dumps.
+ */
+
+namespace handystats { namespace push_export {
+
+bool enabled();
+
+void submit(
+		const std::shared_ptr<const std::map<std::string, metrics::metric_variant>>& dump,
+		const metrics_dump::tags_filter& tags_filter,
+		const std::shared_ptr<const std::string>& binary_dump
+	);
+
+// number of dumps dropped
+uint64_t dropped_count();
+
+void initialize();
+void finalize();
+
+
+namespace stats {
+
+// dropped dumps, updated from dropped_count() on each dump
+extern metrics::counter dropped_count;
+
+void update(const chrono::time_point&);
+
+void initialize();
+void finalize();
+
+} // namespace stats
+
+}} // namespace handystats::push_export
+
+#endif // HANDYSTATS_PUSH_EXPORT_IMPL_HPP_
@@ -0,0 +1,345 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <new>
+#include <string>
+#include <cstring>
+#include <cerrno>
+
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <handystats/shm_export.hpp>
+#include <handystats/binary_dump.hpp>
+
+#include "config_impl.hpp"
+
+#include "shm_export_impl.hpp"
+
+namespace handystats { namespace shm_export {
+
+static const size_t HEADER_SIZE = sizeof(segment_header);
+
+/*
+ * Writer
+ */
+
+static std::string segment_name;
+static int segment_fd = -1;
+static void* segment_data = nullptr;
+static size_t segment_size = 0;
+
+// serialization buffer if binary dump is not rendered
+static std::string buffer;
+
+static segment_header* header() {
+	return static_cast<segment_header*>(segment_data);
+}
+
+static char* payload() {
+	return static_cast<char*>(segment_data) + HEADER_SIZE;
+}
+
+static bool map_segment(const size_t& size) {
+	if (ftruncate(segment_fd, size) != 0) {
+		return false;
+	}
+
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment_fd, 0);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	if (segment_data) {
+		munmap(segment_data, segment_size);
+	}
+
+	segment_data = data;
+	segment_size = size;
+
+	return true;
+}
+
+static void unmap_segment() {
+	if (segment_data) {
+		munmap(segment_data, segment_size);
+		segment_data = nullptr;
+		segment_size = 0;
+	}
+
+	if (segment_fd >= 0) {
+		close(segment_fd);
+		segment_fd = -1;
+	}
+
+	if (!segment_name.empty()) {
+		shm_unlink(segment_name.c_str());
+		segment_name.clear();
+	}
+}
+
+bool enabled() {
+	return segment_data != nullptr;
+}
+
+void publish(
+		const std::map<std::string, metrics::metric_variant>& dump,
+		const metrics_dump::tags_filter& tags_filter,
+		const std::string* binary_dump,
+		const uint64_t& generation
+	)
+{
+	if (!enabled()) {
+		return;
+	}
+
+	const std::string* data = binary_dump;
+	if (!data) {
+		buffer.clear();
+		binary::write_to_string(dump, buffer, tags_filter);
+		data = &buffer;
+	}
+
+	const uint64_t sequence = header()->sequence.load(std::memory_order_relaxed);
+	header()->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	if (data->size() > header()->capacity.load(std::memory_order_relaxed)) {
+		size_t capacity = header()->capacity.load(std::memory_order_relaxed);
+		while (capacity < data->size()) {
+			capacity *= 2;
+		}
+
+		// previous dump stays published on failure
+		if (!map_segment(HEADER_SIZE + capacity)) {
+			header()->sequence.store(sequence + 2, std::memory_order_release);
+			return;
+		}
+
+		header()->capacity.store(capacity, std::memory_order_relaxed);
+	}
+
+	memcpy(payload(), data->data(), data->size());
+	header()->size.store(data->size(), std::memory_order_relaxed);
+	header()->generation.store(generation, std::memory_order_relaxed);
+
+	header()->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+std::string expand_name(const std::string& name, const uint64_t& pid) {
+	std::string expanded;
+	expanded.reserve(name.size() + 16);
+
+	for (size_t index = 0; index < name.size(); ++index) {
+		if (name[index] == '%' && index + 1 < name.size()) {
+			if (name[index + 1] == 'p') {
+				expanded.append(std::to_string(pid));
+				++index;
+				continue;
+			}
+			if (name[index + 1] == '%') {
+				expanded.push_back('%');
+				++index;
+				continue;
+			}
+		}
+		expanded.push_back(name[index]);
+	}
+
+	return expanded;
+}
+
+// segment left by process that is not alive anymore (or by this process) could be replaced
+static bool stale_segment(const std::string& name) {
+	const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		return false;
+	}
+
+	bool stale = false;
+	struct stat segment_stat;
+	if (fstat(fd, &segment_stat) == 0 && size_t(segment_stat.st_size) >= HEADER_SIZE) {
+		void* data = mmap(nullptr, HEADER_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+		if (data != MAP_FAILED) {
+			const segment_header* hdr = static_cast<const segment_header*>(data);
+			if (memcmp(hdr->magic, MAGIC, sizeof(MAGIC)) == 0) {
+				const pid_t owner = pid_t(hdr->pid);
+				stale = (owner == getpid()) || (kill(owner, 0) != 0 && errno == ESRCH);
+			}
+			munmap(data, HEADER_SIZE);
+		}
+	}
+	close(fd);
+
+	return stale;
+}
+
+void initialize() {
+	unmap_segment();
+
+	if (config::shm_export_opts.name.empty()) {
+		return;
+	}
+
+	const std::string name = expand_name(config::shm_export_opts.name, getpid());
+
+	segment_fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (segment_fd < 0 && errno == EEXIST && stale_segment(name)) {
+		// readers of stale segment keep old mapping until they reopen
+		shm_unlink(name.c_str());
+		segment_fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	}
+	if (segment_fd < 0) {
+		return;
+	}
+	segment_name = name;
+
+	if (!map_segment(HEADER_SIZE + config::shm_export_opts.size)) {
+		unmap_segment();
+		return;
+	}
+
+	segment_header* hdr = new (segment_data) segment_header();
+	memcpy(hdr->magic, MAGIC, sizeof(MAGIC));
+	hdr->version = VERSION;
+	hdr->header_size = HEADER_SIZE;
+	hdr->pid = getpid();
+	hdr->capacity.store(config::shm_export_opts.size, std::memory_order_relaxed);
+	hdr->generation.store(0, std::memory_order_relaxed);
+	hdr->size.store(0, std::memory_order_relaxed);
+	hdr->sequence.store(0, std::memory_order_release);
+}
+
+void finalize() {
+	unmap_segment();
+	buffer.clear();
+	buffer.shrink_to_fit();
+}
+
+
+/*
+ * Reader
+ */
+
+reader::reader(const std::string& name)
+	: m_fd(-1)
+	, m_data(nullptr)
+	, m_size(0)
+{
+	m_fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (m_fd < 0) {
+		return;
+	}
+
+	struct stat segment_stat;
+	if (fstat(m_fd, &segment_stat) != 0 || size_t(segment_stat.st_size) < HEADER_SIZE || !remap(segment_stat.st_size)) {
+		close(m_fd);
+		m_fd = -1;
+		return;
+	}
+
+	const segment_header* hdr = static_cast<const segment_header*>(m_data);
+	if (memcmp(hdr->magic, MAGIC, sizeof(MAGIC)) != 0 || hdr->version != VERSION || hdr->header_size != HEADER_SIZE) {
+		munmap(m_data, m_size);
+		m_data = nullptr;
+		m_size = 0;
+		close(m_fd);
+		m_fd = -1;
+	}
+}
+
+reader::~reader() {
+	if (m_data) {
+		munmap(m_data, m_size);
+	}
+	if (m_fd >= 0) {
+		close(m_fd);
+	}
+}
+
+bool reader::valid() const {
+	return m_data != nullptr;
+}
+
+bool reader::remap(const size_t& size) {
+	void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	if (m_data) {
+		munmap(m_data, m_size);
+	}
+
+	m_data = data;
+	m_size = size;
+
+	return true;
+}
+
+bool reader::read(std::string& data, uint64_t* generation, const size_t& max_attempts) {
+	if (!valid()) {
+		return false;
+	}
+
+	for (size_t attempt = 0; attempt < max_attempts; ++attempt) {
+		const segment_header* hdr = static_cast<const segment_header*>(m_data);
+
+		const uint64_t sequence = hdr->sequence.load(std::memory_order_acquire);
+		if (sequence & 1) {
+			sched_yield();
+			continue;
+		}
+		if (sequence == 0) {
+			return false;
+		}
+
+		const uint64_t capacity = hdr->capacity.load(std::memory_order_relaxed);
+		if (HEADER_SIZE + capacity > m_size) {
+			// segment has grown
+			struct stat segment_stat;
+			if (fstat(m_fd, &segment_stat) != 0 || !remap(segment_stat.st_size)) {
+				return false;
+			}
+			continue;
+		}
+
+		const uint64_t size = hdr->size.load(std::memory_order_relaxed);
+		const uint64_t dump_generation = hdr->generation.load(std::memory_order_relaxed);
+		if (size > capacity) {
+			continue;
+		}
+
+		data.assign(static_cast<const char*>(m_data) + HEADER_SIZE, size);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (hdr->sequence.load(std::memory_order_relaxed) == sequence) {
+			if (generation) {
+				*generation = dump_generation;
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+}} // namespace handystats::shm_export
@@ -0,0 +1,47 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#ifndef HANDYSTATS_SHM_EXPORT_IMPL_HPP_
+#define HANDYSTATS_SHM_EXPORT_IMPL_HPP_
+
+#include <string>
+#include <map>
+#include <cstdint>
+
+#include <handystats/metrics.hpp>
+
+#include "dump_filter_impl.hpp"
+
+namespace handystats { namespace shm_export {
+
+// returns true if segment is exported
+bool enabled();
+
+// binary_dump is reused if rendered, otherwise dump is serialized into internal buffer
+void publish(
+		const std::map<std::string, metrics::metric_variant>& dump,
+		const metrics_dump::tags_filter& tags_filter,
+		const std::string* binary_dump,
+		const uint64_t& generation
+	);
+
+void initialize();
+void finalize();
+
+}} // namespace handystats::shm_export
+
+#endif // HANDYSTATS_SHM_EXPORT_IMPL_HPP_
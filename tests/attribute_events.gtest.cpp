@@ -35,9 +35,9 @@ TEST(AttributeEventsTest, TestAttributeSetDoubleEvent) {
 	ASSERT_EQ(message->destination_name, attribute_name);
 	ASSERT_EQ(message->destination_type, handystats::events::event_destination_type::ATTRIBUTE);
 
-	ASSERT_EQ(message->event_type, event_type::SET);
+	ASSERT_EQ(message->event_type, event_type::SET_DOUBLE);
 	ASSERT_NEAR(
-			boost::get<double>(*reinterpret_cast<handystats::metrics::attribute::value_type*>(message->event_data)),
+			boost::get<double>(event_value(*message)),
 			value,
 			1E-6
 		);
@@ -53,9 +53,9 @@ TEST(AttributeEventsTest, TestAttributeSetBoolEvent) {
 	ASSERT_EQ(message->destination_name, attribute_name);
 	ASSERT_EQ(message->destination_type, handystats::events::event_destination_type::ATTRIBUTE);
 
-	ASSERT_EQ(message->event_type, event_type::SET);
+	ASSERT_EQ(message->event_type, event_type::SET_BOOL);
 	ASSERT_EQ(
-			boost::get<bool>(*reinterpret_cast<handystats::metrics::attribute::value_type*>(message->event_data)),
+			boost::get<bool>(event_value(*message)),
 			value
 		);
 
@@ -70,9 +70,9 @@ TEST(AttributeEventsTest, TestAttributeSetIntEvent) {
 	ASSERT_EQ(message->destination_name, attribute_name);
 	ASSERT_EQ(message->destination_type, handystats::events::event_destination_type::ATTRIBUTE);
 
-	ASSERT_EQ(message->event_type, event_type::SET);
+	ASSERT_EQ(message->event_type, event_type::SET_INT);
 	ASSERT_EQ(
-			boost::get<int>(*reinterpret_cast<handystats::metrics::attribute::value_type*>(message->event_data)),
+			boost::get<int>(event_value(*message)),
 			value
 		);
 
@@ -87,9 +87,9 @@ TEST(AttributeEventsTest, TestAttributeSetUintEvent) {
 	ASSERT_EQ(message->destination_name, attribute_name);
 	ASSERT_EQ(message->destination_type, handystats::events::event_destination_type::ATTRIBUTE);
 
-	ASSERT_EQ(message->event_type, event_type::SET);
+	ASSERT_EQ(message->event_type, event_type::SET_UINT);
 	ASSERT_EQ(
-			boost::get<unsigned>(*reinterpret_cast<handystats::metrics::attribute::value_type*>(message->event_data)),
+			boost::get<unsigned>(event_value(*message)),
 			value
 		);
 
@@ -104,9 +104,9 @@ TEST(AttributeEventsTest, TestAttributeSetInt64Event) {
 	ASSERT_EQ(message->destination_name, attribute_name);
 	ASSERT_EQ(message->destination_type, handystats::events::event_destination_type::ATTRIBUTE);
 
-	ASSERT_EQ(message->event_type, event_type::SET);
+	ASSERT_EQ(message->event_type, event_type::SET_INT64);
 	ASSERT_EQ(
-			boost::get<int64_t>(*reinterpret_cast<handystats::metrics::attribute::value_type*>(message->event_data)),
+			boost::get<int64_t>(event_value(*message)),
 			value
 		);
 
@@ -121,9 +121,9 @@ TEST(AttributeEventsTest, TestAttributeSetUint64Event) {
 	ASSERT_EQ(message->destination_name, attribute_name);
 	ASSERT_EQ(message->destination_type, handystats::events::event_destination_type::ATTRIBUTE);
 
-	ASSERT_EQ(message->event_type, event_type::SET);
+	ASSERT_EQ(message->event_type, event_type::SET_UINT64);
 	ASSERT_EQ(
-			boost::get<uint64_t>(*reinterpret_cast<handystats::metrics::attribute::value_type*>(message->event_data)),
+			boost::get<uint64_t>(event_value(*message)),
 			value
 		);
 
@@ -138,11 +138,42 @@ TEST(AttributeEventsTest, TestAttributeSetStringEvent) {
 	ASSERT_EQ(message->destination_name, attribute_name);
 	ASSERT_EQ(message->destination_type, handystats::events::event_destination_type::ATTRIBUTE);
 
+	ASSERT_EQ(message->event_type, event_type::SET_STRING);
+	ASSERT_EQ(
+			boost::get<std::string>(event_value(*message)),
+			value
+		);
+
+	delete_event_message(message);
+}
+
+TEST(AttributeEventsTest, TestAttributeSetLongStringEvent) {
+	const char* attribute_name = "attr.test";
+	const std::string value(MAX_INLINE_STRING_SIZE + 1, 'x');
+	auto message = create_set_event(attribute_name, handystats::metrics::attribute::value_type(value), handystats::metrics::attribute::clock::now());
+
+	ASSERT_EQ(message->destination_name, attribute_name);
+	ASSERT_EQ(message->destination_type, handystats::events::event_destination_type::ATTRIBUTE);
+
 	ASSERT_EQ(message->event_type, event_type::SET);
 	ASSERT_EQ(
-			boost::get<std::string>(*reinterpret_cast<handystats::metrics::attribute::value_type*>(message->event_data)),
+			boost::get<std::string>(event_value(*message)),
 			value
 		);
 
 	delete_event_message(message);
 }
+
+TEST(AttributeEventsTest, TestAttributeSetInlineStringEvent) {
+	const char* attribute_name = "attr.test";
+	const std::string value(MAX_INLINE_STRING_SIZE, 'y');
+	auto message = create_set_event(attribute_name, value.data(), value.size(), handystats::metrics::attribute::clock::now());
+
+	ASSERT_EQ(message->event_type, event_type::SET_STRING);
+
+	handystats::metrics::attribute attribute;
+	process_event(attribute, *message);
+	ASSERT_EQ(boost::get<std::string>(attribute.value()), value);
+
+	delete_event_message(message);
+}
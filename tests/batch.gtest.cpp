@@ -0,0 +1,120 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <handystats/chrono.hpp>
+#include <handystats/metrics.hpp>
+#include <handystats/measuring_points.hpp>
+#include <handystats/core.hpp>
+#include <handystats/metrics_dump.hpp>
+
+#include "message_queue_helper.hpp"
+#include "metrics_dump_helper.hpp"
+
+
+class HandyBatchTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		HANDY_CONFIG_JSON(
+				"{\
+					\"dump-interval\": 10\
+				}"
+			);
+
+		HANDY_INIT();
+	}
+
+	virtual void TearDown() {
+		HANDY_FINALIZE();
+	}
+};
+
+
+TEST_F(HandyBatchTest, SubmitAllMeasurements) {
+	const size_t STEPS = 10;
+
+	handystats::measuring_points::batch batch;
+
+	for (size_t step = 0; step < STEPS; ++step) {
+		batch.counter_increment("batch.counter", 2);
+		batch.gauge_set("batch.gauge", step);
+		batch.timer_set("batch.timer", handystats::chrono::duration(step, handystats::chrono::time_unit::MSEC));
+	}
+	batch.attribute_set("batch.attribute", "value");
+
+	ASSERT_EQ(batch.size(), STEPS * 3 + 1);
+
+	batch.submit();
+	ASSERT_TRUE(batch.empty());
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+
+	auto& counter = boost::get<handystats::metrics::counter>(metrics_dump->at("batch.counter"));
+	ASSERT_EQ(counter.values().get<handystats::statistics::tag::value>(), STEPS * 2);
+
+	auto& gauge = boost::get<handystats::metrics::gauge>(metrics_dump->at("batch.gauge"));
+	ASSERT_EQ(gauge.values().get<handystats::statistics::tag::count>(), STEPS);
+	ASSERT_EQ(gauge.values().get<handystats::statistics::tag::max>(), STEPS - 1);
+
+	auto& timer = boost::get<handystats::metrics::timer>(metrics_dump->at("batch.timer"));
+	ASSERT_EQ(timer.values().get<handystats::statistics::tag::count>(), STEPS);
+
+	auto& attribute = boost::get<handystats::metrics::attribute>(metrics_dump->at("batch.attribute"));
+	ASSERT_EQ(boost::get<std::string>(attribute.value()), "value");
+
+	// whole batch is passed as single message
+	auto& pop_count = boost::get<handystats::metrics::counter>(metrics_dump->at("handystats.message_queue.pop_count"));
+	ASSERT_EQ(pop_count.values().get<handystats::statistics::tag::value>(), 1);
+}
+
+TEST_F(HandyBatchTest, SubmitOnDestruction) {
+	{
+		handystats::measuring_points::batch batch;
+		batch.counter_init("batch.counter", 10);
+		batch.counter_change("batch.counter", -3);
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+
+	auto& counter = boost::get<handystats::metrics::counter>(metrics_dump->at("batch.counter"));
+	ASSERT_EQ(counter.values().get<handystats::statistics::tag::value>(), 7);
+}
+
+TEST_F(HandyBatchTest, DiscardDropsMeasurements) {
+	handystats::measuring_points::batch batch;
+	batch.gauge_set("batch.gauge", 1);
+	batch.discard();
+
+	ASSERT_TRUE(batch.empty());
+
+	batch.submit();
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	ASSERT_TRUE(metrics_dump->find("batch.gauge") == metrics_dump->end());
+}
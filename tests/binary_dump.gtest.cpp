@@ -0,0 +1,222 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <string>
+#include <map>
+
+#include <gtest/gtest.h>
+
+#include <handystats/core.hpp>
+#include <handystats/measuring_points.hpp>
+#include <handystats/metrics_dump.hpp>
+#include <handystats/json_dump.hpp>
+#include <handystats/binary_dump.hpp>
+
+#include <handystats/metrics/gauge.hpp>
+#include <handystats/metrics/counter.hpp>
+#include <handystats/metrics/timer.hpp>
+#include <handystats/metrics/attribute.hpp>
+
+#include "message_queue_helper.hpp"
+#include "metrics_dump_helper.hpp"
+
+using namespace handystats;
+
+static int64_t to_msec(const chrono::time_point& timestamp) {
+	const chrono::time_point system_timestamp = chrono::time_point::convert_to(chrono::clock_type::SYSTEM, timestamp);
+	return chrono::duration::convert_to(chrono::time_unit::MSEC, system_timestamp.time_since_epoch()).count();
+}
+
+static void check_statistics(const statistics& values, const binary::metric_record& record) {
+	ASSERT_EQ(values.tags(), record.tags);
+
+	if (values.enabled(statistics::tag::value)) {
+		ASSERT_EQ(values.get<statistics::tag::value>(), record.value);
+	}
+	if (values.enabled(statistics::tag::min)) {
+		ASSERT_EQ(values.get<statistics::tag::min>(), record.min);
+	}
+	if (values.enabled(statistics::tag::max)) {
+		ASSERT_EQ(values.get<statistics::tag::max>(), record.max);
+	}
+	if (values.enabled(statistics::tag::count)) {
+		ASSERT_EQ(values.get<statistics::tag::count>(), record.count);
+	}
+	if (values.enabled(statistics::tag::sum)) {
+		ASSERT_EQ(values.get<statistics::tag::sum>(), record.sum);
+	}
+	if (values.enabled(statistics::tag::avg)) {
+		ASSERT_EQ(values.get<statistics::tag::avg>(), record.avg);
+	}
+	if (values.enabled(statistics::tag::moving_avg)) {
+		ASSERT_EQ(values.get<statistics::tag::moving_avg>(), record.moving_avg);
+	}
+	if (values.enabled(statistics::tag::histogram)) {
+		const auto& histogram = values.get<statistics::tag::histogram>();
+		ASSERT_EQ(histogram.size(), record.histogram.size());
+		for (size_t index = 0; index < histogram.size(); ++index) {
+			ASSERT_EQ(std::get<statistics::BIN_CENTER>(histogram[index]), record.histogram[index].first);
+			ASSERT_EQ(std::get<statistics::BIN_COUNT>(histogram[index]), record.histogram[index].second);
+		}
+	}
+	if (values.enabled(statistics::tag::quantile)) {
+		ASSERT_EQ(5, record.quantiles.size());
+		for (size_t index = 0; index < record.quantiles.size(); ++index) {
+			ASSERT_EQ(values.get<statistics::tag::quantile>().at(record.quantiles[index].first), record.quantiles[index].second);
+		}
+	}
+	if (values.enabled(statistics::tag::timestamp)) {
+		ASSERT_EQ(to_msec(values.get<statistics::tag::timestamp>()), record.timestamp);
+	}
+	if (values.enabled(statistics::tag::rate)) {
+		ASSERT_EQ(values.get<statistics::tag::rate>(), record.rate);
+	}
+}
+
+TEST(BinaryDumpTest, EncodeDecodeRoundTrip) {
+	config::metrics::gauge gauge_opts;
+	gauge_opts.values.tags =
+		statistics::tag::value | statistics::tag::min | statistics::tag::max |
+		statistics::tag::count | statistics::tag::sum | statistics::tag::avg |
+		statistics::tag::moving_avg | statistics::tag::histogram | statistics::tag::quantile |
+		statistics::tag::timestamp | statistics::tag::rate;
+	metrics::gauge gauge(gauge_opts);
+	for (int value = -100; value <= 100; ++value) {
+		gauge.set(value * 0.37);
+	}
+
+	metrics::counter counter;
+	counter.increment(1 << 20);
+
+	metrics::timer timer;
+	timer.set(chrono::duration(12345, metrics::timer::value_unit));
+
+	std::map<std::string, metrics::metric_variant> metrics_map;
+	metrics_map.insert(std::make_pair("test.gauge", metrics::metric_variant(gauge)));
+	metrics_map.insert(std::make_pair("test.counter", metrics::metric_variant(counter)));
+	metrics_map.insert(std::make_pair("test.timer", metrics::metric_variant(timer)));
+
+	metrics::attribute attr;
+	attr.set(true);
+	metrics_map.insert(std::make_pair("test.attr.bool", metrics::metric_variant(attr)));
+	attr.set(-42);
+	metrics_map.insert(std::make_pair("test.attr.int", metrics::metric_variant(attr)));
+	attr.set(42u);
+	metrics_map.insert(std::make_pair("test.attr.uint", metrics::metric_variant(attr)));
+	attr.set(int64_t(-1) << 62);
+	metrics_map.insert(std::make_pair("test.attr.int64", metrics::metric_variant(attr)));
+	attr.set(uint64_t(-1));
+	metrics_map.insert(std::make_pair("test.attr.uint64", metrics::metric_variant(attr)));
+	attr.set(-0.125);
+	metrics_map.insert(std::make_pair("test.attr.double", metrics::metric_variant(attr)));
+	attr.set(std::string("string value"));
+	metrics_map.insert(std::make_pair("test.attr.string", metrics::metric_variant(attr)));
+
+	const std::string data = binary::to_string(metrics_map);
+
+	binary::snapshot snapshot;
+	ASSERT_TRUE(binary::decode(data, snapshot));
+	ASSERT_EQ(binary::VERSION, snapshot.version);
+	ASSERT_EQ(metrics_map.size(), snapshot.metrics.size());
+
+	for (auto metric_iter = metrics_map.cbegin(); metric_iter != metrics_map.cend(); ++metric_iter) {
+		ASSERT_TRUE(snapshot.metrics.find(metric_iter->first) != snapshot.metrics.end());
+		const auto& record = snapshot.metrics.at(metric_iter->first);
+		ASSERT_EQ(metric_iter->second.which(), record.type);
+
+		switch (metric_iter->second.which()) {
+			case metrics::metric_index::GAUGE:
+				check_statistics(boost::get<metrics::gauge>(metric_iter->second).values(), record);
+				break;
+			case metrics::metric_index::COUNTER:
+				check_statistics(boost::get<metrics::counter>(metric_iter->second).values(), record);
+				break;
+			case metrics::metric_index::TIMER:
+				check_statistics(boost::get<metrics::timer>(metric_iter->second).values(), record);
+				break;
+			case metrics::metric_index::ATTRIBUTE:
+				ASSERT_TRUE(boost::get<metrics::attribute>(metric_iter->second).value() == record.attribute_value);
+				break;
+		}
+	}
+}
+
+TEST(BinaryDumpTest, MalformedDataRejected) {
+	metrics::gauge gauge;
+	gauge.set(1.5);
+	metrics::attribute attr;
+	attr.set(std::string("value"));
+
+	std::map<std::string, metrics::metric_variant> metrics_map;
+	metrics_map.insert(std::make_pair("test.gauge", metrics::metric_variant(gauge)));
+	metrics_map.insert(std::make_pair("test.attr", metrics::metric_variant(attr)));
+
+	const std::string data = binary::to_string(metrics_map);
+
+	binary::snapshot snapshot;
+	ASSERT_TRUE(binary::decode(data, snapshot));
+
+	for (size_t size = 0; size < data.size(); ++size) {
+		ASSERT_FALSE(binary::decode(data.data(), size, snapshot));
+	}
+
+	std::string bad_magic = data;
+	bad_magic[0] = 'X';
+	ASSERT_FALSE(binary::decode(bad_magic, snapshot));
+
+	std::string bad_version = data;
+	bad_version[4] = char(binary::VERSION + 1);
+	ASSERT_FALSE(binary::decode(bad_version, snapshot));
+}
+
+TEST(BinaryDumpTest, SharedBinaryDump) {
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 1,\
+				\"dump-formats\": [\"binary\"]\
+			}"
+		);
+
+	HANDY_INIT();
+
+	for (int i = 0; i < 100; ++i) {
+		HANDY_TIMER_START("test.timer");
+		HANDY_GAUGE_SET("test.gauge", i);
+		HANDY_COUNTER_INCREMENT("test.counter", i);
+		HANDY_ATTRIBUTE_SET("cycle.interation", i);
+		HANDY_TIMER_STOP("test.timer");
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	const auto metrics_dump = HANDY_METRICS_DUMP();
+	const std::string data = binary::to_string(*metrics_dump);
+
+	binary::snapshot snapshot;
+	ASSERT_TRUE(binary::decode(data, snapshot));
+	ASSERT_EQ(metrics_dump->size(), snapshot.metrics.size());
+	for (auto metric_iter = metrics_dump->cbegin(); metric_iter != metrics_dump->cend(); ++metric_iter) {
+		ASSERT_TRUE(snapshot.metrics.find(metric_iter->first) != snapshot.metrics.end());
+	}
+
+	ASSERT_LT(data.size(), handystats::json::to_string(*metrics_dump, false).size());
+
+	ASSERT_TRUE(binary::decode(*HANDY_BINARY_DUMP_SHARED(), snapshot));
+
+	HANDY_FINALIZE();
+}
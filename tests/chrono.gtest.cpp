@@ -0,0 +1,236 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <handystats/chrono.hpp>
+#include <handystats/core.hpp>
+#include <handystats/metrics_dump.hpp>
+#include <handystats/measuring_points/clock.hpp>
+
+#include "chrono_impl.hpp"
+
+#include "metrics_dump_helper.hpp"
+
+using namespace handystats::chrono;
+
+// should run first, before any tick conversion in this binary
+TEST(ChronoTest, TestFrequencyIsSetOnFirstConversion) {
+	ASSERT_FALSE(cycles_per_nanosec_initialized.load());
+
+	tsc_clock::now();
+	ASSERT_FALSE(cycles_per_nanosec_initialized.load());
+
+	ASSERT_GT(duration::convert_to(time_unit::NSEC, duration(1000000, time_unit::TICK)).count(), 0);
+	ASSERT_TRUE(cycles_per_nanosec_initialized.load());
+	ASSERT_GT(cycles_per_nanosec, 0);
+}
+
+TEST(ChronoTest, TestTickConversionMatchesFrequency) {
+	const int64_t nsec_values[] = {0, 1, 999, 1000000, 123456789012LL, 86400LL * 1000000000LL};
+
+	for (size_t index = 0; index < sizeof(nsec_values) / sizeof(nsec_values[0]); ++index) {
+		const int64_t nsec = nsec_values[index];
+
+		const int64_t ticks = duration::convert_to(time_unit::TICK, duration(nsec, time_unit::NSEC)).count();
+		const long double expected_ticks = cycles_per_nanosec * nsec;
+		ASSERT_NEAR(expected_ticks, (long double)ticks, 1 + expected_ticks * 1E-9);
+
+		const int64_t back = duration::convert_to(time_unit::NSEC, duration(ticks, time_unit::TICK)).count();
+		const long double expected_nsec = ticks / cycles_per_nanosec;
+		ASSERT_NEAR(expected_nsec, (long double)back, 1 + expected_nsec * 1E-9);
+	}
+}
+
+TEST(ChronoTest, TestNegativeTickConversion) {
+	const duration positive(1000000007LL, time_unit::TICK);
+	const duration negative(-1000000007LL, time_unit::TICK);
+
+	ASSERT_EQ(
+			-duration::convert_to(time_unit::USEC, positive).count(),
+			duration::convert_to(time_unit::USEC, negative).count()
+		);
+	ASSERT_EQ(
+			-duration::convert_to(time_unit::TICK, duration(12345, time_unit::MSEC)).count(),
+			duration::convert_to(time_unit::TICK, duration(-12345, time_unit::MSEC)).count()
+		);
+}
+
+TEST(ChronoTest, TestRefineSchedule) {
+	ASSERT_EQ(3, TSC_REFINE_STEPS);
+
+	ASSERT_EQ((uint64_t)1E7, tsc_refine_interval(0));
+	ASSERT_EQ((uint64_t)1E8, tsc_refine_interval(1));
+	ASSERT_EQ((uint64_t)1E9, tsc_refine_interval(2));
+
+	// recalibration afterwards
+	ASSERT_EQ((uint64_t)1E10, tsc_refine_interval(3));
+	ASSERT_EQ((uint64_t)1E10, tsc_refine_interval(100));
+}
+
+static int cpuinfo_calls = 0;
+static long double cpuinfo_value = 0;
+
+static long double test_cpuinfo_frequency() {
+	++cpuinfo_calls;
+	return cpuinfo_value;
+}
+
+static int measure_calls = 0;
+
+static long double test_measure_frequency() {
+	++measure_calls;
+	return 2.7L;
+}
+
+TEST(ChronoTest, TestProvisionalFrequencyFallbacks) {
+	cpuinfo_calls = measure_calls = 0;
+	cpuinfo_value = 2.0L;
+
+	// CPUID value is preferred, no other source is queried
+	ASSERT_EQ(3.1L, provisional_cycles_per_nanosec(3.1L, &test_cpuinfo_frequency, &test_measure_frequency));
+	ASSERT_EQ(0, cpuinfo_calls);
+	ASSERT_EQ(0, measure_calls);
+
+	// nominal frequency from /proc/cpuinfo
+	ASSERT_EQ(2.0L, provisional_cycles_per_nanosec(0, &test_cpuinfo_frequency, &test_measure_frequency));
+	ASSERT_EQ(1, cpuinfo_calls);
+	ASSERT_EQ(0, measure_calls);
+
+	// measurement as the last resort
+	cpuinfo_value = 0;
+	ASSERT_EQ(2.7L, provisional_cycles_per_nanosec(0, &test_cpuinfo_frequency, &test_measure_frequency));
+	ASSERT_EQ(2, cpuinfo_calls);
+	ASSERT_EQ(1, measure_calls);
+}
+
+TEST(ChronoTest, TestSlewMovesEstimateTowardMeasured) {
+	const long double measured = 3.0L;
+	long double estimate = measured * (1 + 400E-6L);
+
+	long double drift_ppm;
+	const long double next = slew_cycles_per_nanosec(estimate, measured, &drift_ppm);
+
+	ASSERT_NEAR(400.0, (double)drift_ppm, 1E-6);
+	ASSERT_NEAR((double)(estimate - (estimate - measured) * 0.25L), (double)next, 1E-12);
+
+	// estimate below measured value gives negative drift
+	slew_cycles_per_nanosec(measured * (1 - 400E-6L), measured, &drift_ppm);
+	ASSERT_NEAR(-400.0, (double)drift_ppm, 1E-6);
+
+	for (int step = 0; step < 100; ++step) {
+		const long double previous_gap = estimate - measured;
+		estimate = slew_cycles_per_nanosec(estimate, measured, &drift_ppm);
+		ASSERT_LE(estimate - measured, previous_gap);
+		ASSERT_GE(estimate, measured);
+	}
+	ASSERT_NEAR(0.0, (double)drift_ppm, 1E-6);
+	ASSERT_NEAR((double)measured, (double)estimate, 1E-12);
+}
+
+TEST(ChronoTest, TestSlewResetsOnLargeDrift) {
+	const long double measured = 2.5L;
+
+	long double drift_ppm;
+	ASSERT_EQ(measured, slew_cycles_per_nanosec(measured * (1 + 1500E-6L), measured, &drift_ppm));
+	ASSERT_NEAR(1500.0, (double)drift_ppm, 1E-6);
+
+	ASSERT_EQ(measured, slew_cycles_per_nanosec(measured * (1 - 1500E-6L), measured, &drift_ppm));
+	ASSERT_NEAR(-1500.0, (double)drift_ppm, 1E-6);
+
+	// drift within the limit is slewed
+	ASSERT_NE(measured, slew_cycles_per_nanosec(measured * (1 + 900E-6L), measured, &drift_ppm));
+}
+
+TEST(ChronoTest, TestRebasedAnchorIsContinuous) {
+	tsc_anchor anchor;
+	anchor.base_ticks = 0;
+	anchor.base_nsec = 0;
+	anchor.mult = (uint64_t)1 << (SCALE_SHIFT - 1); // 2 ticks per nanosecond
+
+	// two weeks of uptime
+	const int64_t ticks = 2LL * 14 * 86400 * (int64_t)1E9;
+	const int64_t nsec = anchored_ticks_to_nsec(anchor, ticks);
+
+	const tsc_anchor rebased = rebase_tsc_anchor(anchor, ticks, anchor.mult + (anchor.mult >> 10));
+
+	ASSERT_EQ(nsec, anchored_ticks_to_nsec(rebased, ticks));
+	// new multiplier applies to ticks after the anchor only
+	ASSERT_EQ(nsec + 1000976, anchored_ticks_to_nsec(rebased, ticks + 2000000));
+}
+
+TEST(ChronoTest, TestSystemTimeIsContinuousAcrossFrequencyUpdate) {
+	const long double estimate = cycles_per_nanosec;
+
+	const time_point now = tsc_clock::now();
+	const time_point before = time_point::convert_to(clock_type::SYSTEM, now);
+
+	set_cycles_per_nanosec(estimate * (1 + 500E-6L));
+	const time_point after = time_point::convert_to(clock_type::SYSTEM, now);
+
+	set_cycles_per_nanosec(estimate);
+
+	ASSERT_LT(after - before, duration(1, time_unit::MSEC));
+	ASSERT_GT(after - before, duration(-1, time_unit::MSEC));
+}
+
+TEST(ChronoTest, TestCoarseClockIsRefreshedPeriodically) {
+	HANDY_CONFIG_JSON("{\"counter\": {\"timestamp\": \"coarse\"}}");
+	HANDY_INIT();
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	const time_point first = coarse_clock::now();
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	const time_point coarse = coarse_clock::now();
+	const time_point precise = tsc_clock::now();
+
+	ASSERT_GT(coarse, first);
+	ASSERT_LE(coarse, precise);
+	ASSERT_LT(precise - coarse, duration(100, time_unit::MSEC));
+
+	ASSERT_LE(handystats::measuring_points::counter_clock::now(), tsc_clock::now());
+
+	HANDY_FINALIZE();
+
+	// falls back to tsc_clock once core is stopped
+	ASSERT_GE(coarse_clock::now(), precise);
+}
+
+TEST(ChronoTest, TestTscDriftIsDumped) {
+	HANDY_CONFIG_JSON("{\"dump-interval\": 10}");
+	HANDY_INIT();
+
+	handystats::metrics_dump::wait_until(system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+
+	// POSIX clock sources are not calibrated
+	if (!tsc_calibration_enabled()) {
+		ASSERT_TRUE(metrics_dump->find("handystats.chrono.tsc_drift") == metrics_dump->end());
+		HANDY_FINALIZE();
+		return;
+	}
+
+	ASSERT_TRUE(metrics_dump->find("handystats.chrono.tsc_drift") != metrics_dump->end());
+	ASSERT_NO_THROW(boost::get<handystats::metrics::gauge>(metrics_dump->at("handystats.chrono.tsc_drift")));
+
+	HANDY_FINALIZE();
+}
@@ -0,0 +1,97 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#define HANDYSTATS_DISABLE_ATTRIBUTE
+#define HANDYSTATS_DISABLE_TIMER_PREFIX "debug."
+
+#include <gtest/gtest.h>
+
+#include <handystats/chrono.hpp>
+#include <handystats/metrics.hpp>
+#include <handystats/measuring_points.hpp>
+#include <handystats/core.hpp>
+#include <handystats/metrics_dump.hpp>
+
+#include "message_queue_helper.hpp"
+#include "metrics_dump_helper.hpp"
+
+// never defined, any generated call would fail at link time
+void compiled_out_measuring_point(const char* name, const int& value);
+
+static int evaluations_count = 0;
+
+static int evaluate(const int& value) {
+	evaluations_count++;
+	return value;
+}
+
+static_assert(HANDY_PP_METRIC_NAME_COMPILED_OUT("debug.", "debug.timer"), "name should be compiled out");
+static_assert(HANDY_PP_METRIC_NAME_COMPILED_OUT("debug.", ("debug.timer.%d", 1)), "name format should be compiled out");
+static_assert(!HANDY_PP_METRIC_NAME_COMPILED_OUT("debug.", "release.timer"), "name should not be compiled out");
+static_assert(!HANDY_PP_METRIC_NAME_COMPILED_OUT("", "debug.timer"), "empty prefix should not compile out anything");
+
+
+class CompileOutTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		HANDY_CONFIG_JSON(
+				"{\
+					\"dump-interval\": 10\
+				}"
+			);
+
+		HANDY_INIT();
+
+		evaluations_count = 0;
+	}
+
+	virtual void TearDown() {
+		HANDY_FINALIZE();
+	}
+};
+
+TEST_F(CompileOutTest, NoCodeGeneratedForCompiledOutMeasuringPoint) {
+	HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER("debug.", compiled_out_measuring_point, "debug.name", evaluate(1));
+	HANDY_PP_FILTERED_MEASURING_POINT_WRAPPER("debug.", compiled_out_measuring_point, ("debug.name.%d", evaluate(1)), evaluate(1));
+
+	ASSERT_EQ(evaluations_count, 0);
+}
+
+TEST_F(CompileOutTest, CompiledOutMeasuringPointsAreNotEvaluated) {
+	HANDY_ATTRIBUTE_SET_INT("attribute", evaluate(1));
+	HANDY_TIMER_SET("debug.timer", handystats::chrono::duration(evaluate(1), handystats::chrono::time_unit::MSEC));
+	HANDY_TIMER_START(("debug.timer.%d", evaluate(1)), evaluate(1));
+
+	ASSERT_EQ(evaluations_count, 0);
+
+	HANDY_TIMER_SET("release.timer", handystats::chrono::duration(evaluate(1), handystats::chrono::time_unit::MSEC));
+	HANDY_COUNTER_INCREMENT("debug.counter", evaluate(1));
+
+	ASSERT_EQ(evaluations_count, 2);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+
+	ASSERT_TRUE(metrics_dump->find("attribute") == metrics_dump->end());
+	ASSERT_TRUE(metrics_dump->find("debug.timer") == metrics_dump->end());
+	ASSERT_TRUE(metrics_dump->find("debug.timer.1") == metrics_dump->end());
+
+	ASSERT_TRUE(metrics_dump->find("release.timer") != metrics_dump->end());
+	ASSERT_TRUE(metrics_dump->find("debug.counter") != metrics_dump->end());
+}
@@ -318,3 +318,82 @@ TEST_F(HandyConfigurationTest, MetricsConfigOverwritesStatistcs) {
 
 	ASSERT_FALSE(gauge.values().computed(handystats::statistics::tag::histogram));
 }
+
+TEST_F(HandyConfigurationTest, PatternOptionsAreParsedOnConfiguration) {
+	HANDY_CONFIG_JSON(
+			"{\
+				\"defaults\": {\
+					\"histogram-bins\": 50,\
+					\"moving-interval\": 2000\
+				},\
+				\"test.{a,b}\": {\
+					\"histogram-bins\": 10,\
+					\"tags\": [\"histogram\"]\
+				},\
+				\"dump-interval\": 1\
+			}"
+		);
+
+	ASSERT_TRUE(handystats::config::select_pattern("test.c") == nullptr);
+
+	const handystats::config::pattern_options* pattern_cfg = handystats::config::select_pattern("test.b");
+	ASSERT_TRUE(pattern_cfg != nullptr);
+	ASSERT_EQ(10, pattern_cfg->gauge.values.histogram_bins);
+	ASSERT_EQ(10, pattern_cfg->timer.values.histogram_bins);
+	ASSERT_EQ(handystats::statistics::tag::histogram, pattern_cfg->counter.values.tags);
+	ASSERT_EQ(handystats::config::metrics::gauge_opts.values.moving_interval.count(), pattern_cfg->gauge.values.moving_interval.count());
+
+	HANDY_INIT();
+
+	for (int i = 0; i < 10; ++i) {
+		HANDY_GAUGE_SET("test.a", i);
+		HANDY_GAUGE_SET("test.c", i);
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+
+	auto pattern_gauge = boost::get<handystats::metrics::gauge>(metrics_dump->at("test.a"));
+	ASSERT_EQ(handystats::statistics::tag::histogram, pattern_gauge.values().tags());
+	ASSERT_EQ(10, pattern_gauge.values().get<handystats::statistics::tag::histogram>().size());
+
+	auto default_gauge = boost::get<handystats::metrics::gauge>(metrics_dump->at("test.c"));
+	ASSERT_EQ(handystats::config::metrics::gauge_opts.values.tags, default_gauge.values().tags());
+}
+
+TEST_F(HandyConfigurationTest, CoarseTimestampOption) {
+	HANDY_CONFIG_JSON(
+			"{\
+				\"counter\": {\
+					\"timestamp\": \"coarse\"\
+				},\
+				\"gauge\": {\
+					\"timestamp\": \"precise\"\
+				},\
+				\"dump-interval\": 2\
+			}"
+		);
+
+	ASSERT_TRUE(handystats::config::metrics::counter_opts.coarse_timestamp);
+	ASSERT_FALSE(handystats::config::metrics::gauge_opts.coarse_timestamp);
+
+	HANDY_INIT();
+
+	for (int i = 0; i < 100; ++i) {
+		HANDY_COUNTER_INCREMENT("coarse.counter", 1);
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	while (metrics_dump->find("coarse.counter") == metrics_dump->end()) {
+		std::this_thread::sleep_for(std::chrono::microseconds(10));
+		metrics_dump = HANDY_METRICS_DUMP();
+	}
+
+	auto& counter = boost::get<handystats::metrics::counter>(metrics_dump->at("coarse.counter"));
+	ASSERT_EQ(100, counter.values().get<handystats::statistics::tag::value>());
+}
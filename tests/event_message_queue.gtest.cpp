@@ -18,8 +18,11 @@
 #include <chrono>
 #include <thread>
 #include <memory>
+#include <vector>
 #include <handystats/atomic.hpp>
+#include <pthread.h>
 
+#include <handystats/core.hpp>
 #include <handystats/measuring_points.hpp>
 
 #include <gtest/gtest.h>
@@ -27,12 +30,6 @@
 #include "events/event_message_impl.hpp"
 #include "message_queue_impl.hpp"
 
-namespace handystats {
-
-extern std::atomic<bool> enabled_flag;
-
-} // namespace handystats
-
 class EventMessageQueueTest : public ::testing::Test {
 protected:
 	virtual void SetUp() {
@@ -77,3 +74,67 @@ TEST_F(EventMessageQueueTest, PushDifferentMessages) {
 	ASSERT_EQ(handystats::message_queue::size(), 3);
 }
 
+
+TEST_F(EventMessageQueueTest, ConcurrentPushesCorrectlyCounted) {
+	const size_t THREADS_COUNT = 8;
+	const size_t PUSH_COUNT = 1000;
+
+	std::vector<std::thread> producers;
+	for (size_t thread_index = 0; thread_index < THREADS_COUNT; ++thread_index) {
+		producers.push_back(std::thread(
+					[PUSH_COUNT] () {
+						for (size_t push_index = 0; push_index < PUSH_COUNT; ++push_index) {
+							HANDY_COUNTER_INCREMENT("counter.name", 1);
+						}
+					}
+				)
+			);
+	}
+
+	for (auto& producer : producers) {
+		producer.join();
+	}
+
+	ASSERT_EQ(handystats::message_queue::size(), THREADS_COUNT * PUSH_COUNT);
+
+	for (size_t pop_index = 0; pop_index < PUSH_COUNT; ++pop_index) {
+		handystats::events::delete_event_message(handystats::message_queue::pop());
+	}
+
+	ASSERT_EQ(handystats::message_queue::size(), (THREADS_COUNT - 1) * PUSH_COUNT);
+	ASSERT_FALSE(handystats::message_queue::empty());
+}
+
+static void push_on_thread_exit(void*) {
+	HANDY_COUNTER_INCREMENT("counter.thread_exit", 1);
+}
+
+TEST_F(EventMessageQueueTest, PushesFromThreadExitAreCounted) {
+	// producer slot key is created before the test's key, so its destructor runs first
+	HANDY_COUNTER_INCREMENT("counter.name", 1);
+
+	pthread_key_t exit_key;
+	ASSERT_EQ(0, pthread_key_create(&exit_key, push_on_thread_exit));
+
+	std::thread producer(
+			[exit_key] () {
+				HANDY_COUNTER_INCREMENT("counter.name", 1);
+				pthread_setspecific(exit_key, (void*)1);
+			}
+		);
+	producer.join();
+
+	ASSERT_EQ(handystats::message_queue::size(), 3);
+
+	// released slot is reused by another producer
+	std::thread next_producer(
+			[] () {
+				HANDY_COUNTER_INCREMENT("counter.name", 1);
+			}
+		);
+	next_producer.join();
+
+	ASSERT_EQ(handystats::message_queue::size(), 4);
+
+	pthread_key_delete(exit_key);
+}
@@ -34,6 +34,13 @@
 #include "message_queue_helper.hpp"
 #include "metrics_dump_helper.hpp"
 
+static int evaluations_count = 0;
+
+static int evaluate(const int& value) {
+	evaluations_count++;
+	return value;
+}
+
 class HandyCounterTest : public ::testing::Test {
 protected:
 	virtual void SetUp() {
@@ -142,3 +149,45 @@ TEST_F(HandyGaugeTest, HandyQueueSizeMonitoring) {
 	ASSERT_EQ(handy_max_size, max_queue_size);
 }
 
+
+TEST_F(HandyCounterTest, MeasuringPointsFollowRuntimeEnablement) {
+	evaluations_count = 0;
+
+	HANDY_COUNTER_INCREMENT("toggle.counter", evaluate(1));
+	ASSERT_EQ(1, evaluations_count);
+
+	HANDY_FINALIZE();
+
+	// arguments are not evaluated while handystats is disabled
+	HANDY_COUNTER_INCREMENT("toggle.counter", evaluate(1));
+	HANDY_COUNTER_INCREMENT(("toggle.counter.%d", evaluate(1)), evaluate(1));
+	ASSERT_EQ(1, evaluations_count);
+
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10\
+			}"
+		);
+	HANDY_INIT();
+
+	// measuring points with plain metric names are expressions
+	const bool enabled = true;
+	enabled ? HANDY_COUNTER_INCREMENT("toggle.counter", evaluate(1)) : void();
+	(HANDY_COUNTER_INCREMENT("toggle.counter", evaluate(1)), HANDY_GAUGE_SET("toggle.gauge", evaluate(2)));
+	ASSERT_EQ(4, evaluations_count);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	while (metrics_dump->find("toggle.gauge") == metrics_dump->end()) {
+		std::this_thread::sleep_for(std::chrono::microseconds(10));
+		metrics_dump = HANDY_METRICS_DUMP();
+	}
+
+	auto& counter = boost::get<handystats::metrics::counter>(metrics_dump->at("toggle.counter"));
+	ASSERT_EQ(2, counter.values().get<handystats::statistics::tag::value>());
+
+	auto& gauge = boost::get<handystats::metrics::gauge>(metrics_dump->at("toggle.gauge"));
+	ASSERT_EQ(2, gauge.values().get<handystats::statistics::tag::value>());
+}
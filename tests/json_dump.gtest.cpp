@@ -19,6 +19,8 @@
 #include <chrono>
 #include <string>
 
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 
 #include <handystats/core.hpp>
@@ -150,3 +152,199 @@ TEST(JsonDumpTest, CheckEmptyStatisticsNotShown) {
 
 	HANDY_FINALIZE();
 }
+
+TEST(JsonDumpTest, StreamingWritersMatchDomDump) {
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 1\
+			}"
+		);
+
+	HANDY_INIT();
+
+	for (int i = 0; i < 10; ++i) {
+		HANDY_TIMER_START("test.timer");
+		HANDY_GAUGE_SET("test.gauge", i);
+		HANDY_COUNTER_INCREMENT("test.counter", i);
+		HANDY_ATTRIBUTE_SET("cycle.interation", i);
+		HANDY_ATTRIBUTE_SET("cycle.string", std::string("value"));
+		HANDY_TIMER_STOP("test.timer");
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+
+	rapidjson::Document dump;
+	handystats::json::fill(dump, dump.GetAllocator(), *metrics_dump);
+
+	rapidjson::GenericStringBuffer<rapidjson::UTF8<>, rapidjson::Document::AllocatorType> buffer(&dump.GetAllocator());
+	rapidjson::Writer<rapidjson::GenericStringBuffer<rapidjson::UTF8<>, rapidjson::Document::AllocatorType>> writer(buffer);
+	dump.Accept(writer);
+
+	const std::string compact_dump(buffer.GetString(), buffer.GetSize());
+
+	ASSERT_EQ(compact_dump, handystats::json::to_string(*metrics_dump, false));
+
+	std::string reused_buffer;
+	handystats::json::write_to_string(*metrics_dump, reused_buffer, false);
+	ASSERT_EQ(compact_dump, reused_buffer);
+
+	check_full_json_dump(compact_dump);
+
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+
+	std::thread reader(
+			[&] () {
+				char chunk[4096];
+				ssize_t res;
+				reused_buffer.clear();
+				while ((res = read(fds[0], chunk, sizeof(chunk))) > 0) {
+					reused_buffer.append(chunk, res);
+				}
+			}
+		);
+
+	const bool written = handystats::json::write_to_fd(*metrics_dump, fds[1], false);
+	close(fds[1]);
+	reader.join();
+	close(fds[0]);
+
+	ASSERT_TRUE(written);
+	ASSERT_EQ(compact_dump, reused_buffer);
+
+	HANDY_FINALIZE();
+}
+
+TEST(JsonDumpTest, SharedJsonDumpRenderedOncePerDump) {
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 100000\
+			}"
+		);
+
+	const auto init_time = handystats::chrono::system_clock::now() - handystats::chrono::duration(1, handystats::chrono::time_unit::SEC);
+
+	HANDY_INIT();
+
+	handystats::metrics_dump::wait_until(init_time);
+
+	auto first_dump = HANDY_JSON_DUMP_SHARED();
+	auto second_dump = HANDY_JSON_DUMP_SHARED();
+
+	ASSERT_TRUE(first_dump.get() != nullptr);
+	ASSERT_EQ(first_dump.get(), second_dump.get());
+	ASSERT_EQ(*first_dump, handystats::json::to_string(*HANDY_METRICS_DUMP()));
+	ASSERT_EQ(*first_dump, HANDY_JSON_DUMP());
+
+	check_full_json_dump(*first_dump);
+
+	HANDY_FINALIZE();
+}
+
+TEST(JsonDumpTest, SharedJsonDumpRenderedAgainForNextDump) {
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10\
+			}"
+		);
+
+	HANDY_INIT();
+
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto first_dump = HANDY_JSON_DUMP_SHARED();
+
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto next_dump = HANDY_JSON_DUMP_SHARED();
+
+	ASSERT_NE(first_dump.get(), next_dump.get());
+	ASSERT_NE(*first_dump, *next_dump);
+
+	HANDY_FINALIZE();
+}
+
+TEST(JsonDumpTest, SharedJsonDumpRenderedEagerly) {
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 100000,\
+				\"dump-formats\": [\"json\"]\
+			}"
+		);
+
+	const auto init_time = handystats::chrono::system_clock::now() - handystats::chrono::duration(1, handystats::chrono::time_unit::SEC);
+
+	HANDY_INIT();
+
+	handystats::metrics_dump::wait_until(init_time);
+
+	auto first_dump = HANDY_JSON_DUMP_SHARED();
+	auto second_dump = HANDY_JSON_DUMP_SHARED();
+
+	ASSERT_EQ(first_dump.get(), second_dump.get());
+	ASSERT_EQ(*first_dump, handystats::json::to_string(*HANDY_METRICS_DUMP()));
+
+	HANDY_FINALIZE();
+}
+
+TEST(JsonDumpTest, DumpFilterSelectsStatistics) {
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 1,\
+				\"timer\": {\
+					\"tags\": [\"value\", \"count\", \"histogram\", \"quantile\", \"rate\"]\
+				},\
+				\"dump-filter\": {\
+					\"test.{timer,other}\": [\"quantile\", \"rate\"],\
+					\"test.gauge\": []\
+				}\
+			}"
+		);
+
+	HANDY_INIT();
+
+	for (int i = 0; i < 10; ++i) {
+		HANDY_TIMER_START("test.timer");
+		HANDY_GAUGE_SET("test.gauge", i);
+		HANDY_COUNTER_INCREMENT("test.counter", i);
+		HANDY_TIMER_STOP("test.timer");
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+
+	rapidjson::Document dump;
+	dump.Parse<0>(HANDY_JSON_DUMP().c_str());
+	ASSERT_TRUE(dump.IsObject());
+
+	const rapidjson::Value& timer = dump["test.timer"];
+	ASSERT_TRUE(timer.IsObject());
+	ASSERT_TRUE(timer.HasMember("p95"));
+	ASSERT_TRUE(timer.HasMember("rate"));
+	ASSERT_FALSE(timer.HasMember("value"));
+	ASSERT_FALSE(timer.HasMember("count"));
+	ASSERT_FALSE(timer.HasMember("histogram"));
+
+	ASSERT_TRUE(dump["test.gauge"].IsNull());
+
+	ASSERT_TRUE(dump["test.counter"].IsObject());
+	ASSERT_TRUE(dump["test.counter"].HasMember("value"));
+
+	// unfiltered serialization still contains all enabled statistics
+	rapidjson::Document full_dump;
+	handystats::json::fill(full_dump, full_dump.GetAllocator(), *metrics_dump);
+	ASSERT_TRUE(full_dump["test.timer"].HasMember("histogram"));
+
+	// explicit serialization of metrics map is not affected by dump-filter
+	rapidjson::Document explicit_dump;
+	explicit_dump.Parse<0>(handystats::json::to_string(*metrics_dump).c_str());
+	ASSERT_TRUE(explicit_dump["test.timer"].HasMember("histogram"));
+	ASSERT_TRUE(explicit_dump["test.gauge"].IsObject());
+
+	HANDY_FINALIZE();
+}
@@ -16,6 +16,7 @@
  */
 
 #include <vector>
+#include <algorithm>
 #include <utility>
 #include <cstdlib>
 #include <thread>
@@ -121,3 +122,379 @@ TEST_F(MetricsDumpTest, SampleGauge) {
 	ASSERT_EQ(gauge.values().get<handystats::statistics::tag::max>(), MAX_VALUE);
 	ASSERT_EQ(gauge.values().get<handystats::statistics::tag::avg>(), (MAX_VALUE + MIN_VALUE) / 2.0);
 }
+
+TEST_F(MetricsDumpTest, DeltaDumpContainsOnlyChangedMetrics) {
+	HANDY_FINALIZE();
+
+	// moving statistics decay without events, so they are not computed here
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10,\
+				\"delta.*\": {\
+					\"tags\": [\"value\", \"count\"]\
+				}\
+			}"
+		);
+	HANDY_INIT();
+
+	HANDY_GAUGE_SET("delta.changed", 1);
+	HANDY_GAUGE_SET("delta.idle", 1);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto full_delta = HANDY_METRICS_DUMP_DELTA();
+	ASSERT_TRUE(full_delta.full);
+	ASSERT_GT(full_delta.generation, 0);
+	ASSERT_TRUE(full_delta.changed.find("delta.changed") != full_delta.changed.end());
+	ASSERT_TRUE(full_delta.changed.find("delta.idle") != full_delta.changed.end());
+	ASSERT_TRUE(full_delta.removed.empty());
+
+	HANDY_GAUGE_SET("delta.changed", 2);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto delta = HANDY_METRICS_DUMP_DELTA(full_delta.generation);
+	ASSERT_FALSE(delta.full);
+	ASSERT_GT(delta.generation, full_delta.generation);
+	ASSERT_TRUE(delta.changed.find("delta.changed") != delta.changed.end());
+	ASSERT_TRUE(delta.changed.find("delta.idle") == delta.changed.end());
+	ASSERT_TRUE(delta.changed.find("handystats.dump_timestamp") != delta.changed.end());
+	ASSERT_TRUE(delta.removed.empty());
+
+	auto& gauge = boost::get<handystats::metrics::gauge>(delta.changed.at("delta.changed"));
+	ASSERT_EQ(gauge.values().get<handystats::statistics::tag::value>(), 2);
+
+	auto empty_delta = HANDY_METRICS_DUMP_DELTA(delta.generation);
+	ASSERT_FALSE(empty_delta.full);
+	ASSERT_TRUE(empty_delta.changed.find("delta.changed") == empty_delta.changed.end());
+
+	// generations are not reused after reinitialization
+	HANDY_FINALIZE();
+
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10\
+			}"
+		);
+	HANDY_INIT();
+
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto reinit_delta = HANDY_METRICS_DUMP_DELTA(delta.generation);
+	ASSERT_TRUE(reinit_delta.full);
+	ASSERT_GT(reinit_delta.generation, delta.generation);
+	ASSERT_TRUE(reinit_delta.changed.find("delta.changed") == reinit_delta.changed.end());
+}
+
+TEST_F(MetricsDumpTest, DecayingIdleMetricsAreInDeltaDump) {
+	HANDY_FINALIZE();
+
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10,\
+				\"decay.*\": {\
+					\"moving-interval\": 100\
+				}\
+			}"
+		);
+	HANDY_INIT();
+
+	HANDY_GAUGE_SET("decay.gauge", 1);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto full_delta = HANDY_METRICS_DUMP_DELTA();
+	ASSERT_TRUE(full_delta.changed.find("decay.gauge") != full_delta.changed.end());
+	auto& active_gauge = boost::get<handystats::metrics::gauge>(full_delta.changed.at("decay.gauge"));
+	ASSERT_GT(active_gauge.values().get<handystats::statistics::tag::moving_count>(), 0);
+
+	// moving statistics of idle metric decay to zero within moving interval
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto decayed_delta = HANDY_METRICS_DUMP_DELTA(full_delta.generation);
+	ASSERT_FALSE(decayed_delta.full);
+	ASSERT_TRUE(decayed_delta.changed.find("decay.gauge") != decayed_delta.changed.end());
+	auto& idle_gauge = boost::get<handystats::metrics::gauge>(decayed_delta.changed.at("decay.gauge"));
+	ASSERT_EQ(idle_gauge.values().get<handystats::statistics::tag::moving_count>(), 0);
+	ASSERT_EQ(idle_gauge.values().get<handystats::statistics::tag::moving_sum>(), 0);
+	ASSERT_EQ(idle_gauge.values().get<handystats::statistics::tag::value>(), 1);
+
+	// once decayed, idle metric is not changed anymore
+	const uint64_t decayed_generation = decayed_delta.generation;
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto idle_delta = HANDY_METRICS_DUMP_DELTA(decayed_generation);
+	ASSERT_FALSE(idle_delta.full);
+	ASSERT_GT(idle_delta.generation, decayed_generation);
+	ASSERT_TRUE(idle_delta.changed.find("decay.gauge") == idle_delta.changed.end());
+}
+
+TEST_F(MetricsDumpTest, IdleMetricsAreEvicted) {
+	HANDY_FINALIZE();
+
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10,\
+				\"registry\": {\
+					\"ttl\": 50\
+				}\
+			}"
+		);
+	HANDY_INIT();
+
+	HANDY_GAUGE_SET("registry.idle", 1);
+	HANDY_GAUGE_SET("registry.active", 1);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto first_dump = HANDY_METRICS_DUMP();
+	ASSERT_TRUE(first_dump->find("registry.idle") != first_dump->end());
+	const uint64_t first_generation = HANDY_METRICS_DUMP_DELTA().generation;
+
+	for (int i = 0; i < 20; ++i) {
+		HANDY_GAUGE_SET("registry.active", i);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	ASSERT_TRUE(metrics_dump->find("registry.idle") == metrics_dump->end());
+	ASSERT_TRUE(metrics_dump->find("registry.active") != metrics_dump->end());
+
+	auto& evicted_count = boost::get<handystats::metrics::counter>(metrics_dump->at("handystats.internal.evicted_count"));
+	ASSERT_EQ(evicted_count.values().get<handystats::statistics::tag::value>(), 1);
+
+	auto delta = HANDY_METRICS_DUMP_DELTA(first_generation);
+	ASSERT_FALSE(delta.full);
+	ASSERT_TRUE(std::find(delta.removed.begin(), delta.removed.end(), "registry.idle") != delta.removed.end());
+}
+
+TEST_F(MetricsDumpTest, LeastRecentlyUpdatedMetricsAreEvictedAboveMaxSize) {
+	HANDY_FINALIZE();
+
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 1000,\
+				\"registry\": {\
+					\"max-size\": 5\
+				}\
+			}"
+		);
+	HANDY_INIT();
+
+	for (int i = 0; i < 10; ++i) {
+		HANDY_GAUGE_SET(("registry.%d", i), i);
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	for (int i = 0; i < 10; ++i) {
+		const bool present = metrics_dump->find("registry." + std::to_string(i)) != metrics_dump->end();
+		ASSERT_EQ(i >= 5, present) << "registry." << i;
+	}
+
+	auto& evicted_count = boost::get<handystats::metrics::counter>(metrics_dump->at("handystats.internal.evicted_count"));
+	ASSERT_EQ(evicted_count.values().get<handystats::statistics::tag::value>(), 5);
+
+	// max-size is enforced on insertion, registry size is measured after each event
+	auto& registry_size = boost::get<handystats::metrics::gauge>(metrics_dump->at("handystats.internal.size"));
+	ASSERT_EQ(registry_size.values().get<handystats::statistics::tag::value>(), 5);
+}
+
+TEST_F(MetricsDumpTest, TimersWithRunningInstancesAreNotEvicted) {
+	HANDY_FINALIZE();
+
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10,\
+				\"registry\": {\
+					\"ttl\": 50\
+				}\
+			}"
+		);
+	HANDY_INIT();
+
+	HANDY_TIMER_START("registry.running");
+	HANDY_TIMER_START("registry.stopped");
+	HANDY_TIMER_STOP("registry.stopped");
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto idle_dump = HANDY_METRICS_DUMP();
+	ASSERT_TRUE(idle_dump->find("registry.stopped") == idle_dump->end());
+	ASSERT_TRUE(idle_dump->find("registry.running") != idle_dump->end());
+
+	HANDY_TIMER_STOP("registry.running");
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	ASSERT_TRUE(metrics_dump->find("registry.running") != metrics_dump->end());
+
+	auto& timer = boost::get<handystats::metrics::timer>(metrics_dump->at("registry.running"));
+	ASSERT_EQ(timer.values().get<handystats::statistics::tag::count>(), 1);
+	ASSERT_GE(
+			timer.values().get<handystats::statistics::tag::min>(),
+			handystats::chrono::duration::convert_to(handystats::metrics::timer::value_unit,
+				handystats::chrono::duration(200, handystats::chrono::time_unit::MSEC)).count()
+		);
+}
+
+TEST_F(MetricsDumpTest, MetricsAbovePatternLimitAreFoldedIntoOverflow) {
+	HANDY_FINALIZE();
+
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10,\
+				\"limited.*\": {\
+					\"max-metrics\": 3\
+				}\
+			}"
+		);
+	HANDY_INIT();
+
+	for (int i = 0; i < 10; ++i) {
+		HANDY_COUNTER_INCREMENT(("limited.%d", i), 1);
+	}
+	// registered metrics are still updated once limit is reached
+	HANDY_COUNTER_INCREMENT("limited.0", 1);
+	HANDY_COUNTER_INCREMENT("unlimited.0", 1);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	// dump timestamp is subject to TSC drift, wait for the last event to be dumped as well
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	while (metrics_dump->find("unlimited.0") == metrics_dump->end()) {
+		std::this_thread::sleep_for(std::chrono::microseconds(10));
+		metrics_dump = HANDY_METRICS_DUMP();
+	}
+	for (int i = 0; i < 10; ++i) {
+		const bool present = metrics_dump->find("limited." + std::to_string(i)) != metrics_dump->end();
+		ASSERT_EQ(i < 3, present) << "limited." << i;
+	}
+	ASSERT_TRUE(metrics_dump->find("unlimited.0") != metrics_dump->end());
+
+	auto& limited = boost::get<handystats::metrics::counter>(metrics_dump->at("limited.0"));
+	ASSERT_EQ(limited.values().get<handystats::statistics::tag::value>(), 2);
+
+	auto& overflow = boost::get<handystats::metrics::counter>(metrics_dump->at("limited.*.__overflow__.counter"));
+	ASSERT_EQ(overflow.values().get<handystats::statistics::tag::value>(), 7);
+
+	auto& overflow_count = boost::get<handystats::metrics::counter>(metrics_dump->at("handystats.internal.overflow_count"));
+	ASSERT_EQ(overflow_count.values().get<handystats::statistics::tag::value>(), 7);
+}
+
+TEST_F(MetricsDumpTest, OverflowMetricsAreKeptPerType) {
+	HANDY_FINALIZE();
+
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10,\
+				\"mixed.*\": {\
+					\"max-metrics\": 1\
+				}\
+			}"
+		);
+	HANDY_INIT();
+
+	HANDY_COUNTER_INCREMENT("mixed.counter.0", 1);
+	for (int i = 1; i < 4; ++i) {
+		HANDY_COUNTER_INCREMENT(("mixed.counter.%d", i), 2);
+		HANDY_GAUGE_SET(("mixed.gauge.%d", i), 5);
+		HANDY_TIMER_START(("mixed.timer.%d", i));
+		HANDY_TIMER_STOP(("mixed.timer.%d", i));
+	}
+	HANDY_COUNTER_INCREMENT("unlimited.0", 1);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	// dump timestamp is subject to TSC drift, wait for the last event to be dumped as well
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	while (metrics_dump->find("unlimited.0") == metrics_dump->end()) {
+		std::this_thread::sleep_for(std::chrono::microseconds(10));
+		metrics_dump = HANDY_METRICS_DUMP();
+	}
+
+	ASSERT_TRUE(metrics_dump->find("mixed.*.__overflow__.attribute") == metrics_dump->end());
+
+	auto& counter_overflow = boost::get<handystats::metrics::counter>(metrics_dump->at("mixed.*.__overflow__.counter"));
+	ASSERT_EQ(counter_overflow.values().get<handystats::statistics::tag::value>(), 6);
+
+	auto& gauge_overflow = boost::get<handystats::metrics::gauge>(metrics_dump->at("mixed.*.__overflow__.gauge"));
+	ASSERT_EQ(gauge_overflow.values().get<handystats::statistics::tag::value>(), 5);
+
+	auto& timer_overflow = boost::get<handystats::metrics::timer>(metrics_dump->at("mixed.*.__overflow__.timer"));
+	ASSERT_EQ(timer_overflow.values().get<handystats::statistics::tag::count>(), 3);
+
+	auto& overflow_count = boost::get<handystats::metrics::counter>(metrics_dump->at("handystats.internal.overflow_count"));
+	ASSERT_EQ(overflow_count.values().get<handystats::statistics::tag::value>(), 12);
+}
+
+TEST_F(MetricsDumpTest, EvictedOverflowMetricIsCreatedAgain) {
+	HANDY_FINALIZE();
+
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 10,\
+				\"registry\": {\
+					\"ttl\": 50\
+				},\
+				\"limited.*\": {\
+					\"max-metrics\": 1\
+				}\
+			}"
+		);
+	HANDY_INIT();
+
+	HANDY_COUNTER_INCREMENT("limited.0", 1);
+	HANDY_COUNTER_INCREMENT("limited.1", 5);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto first_dump = HANDY_METRICS_DUMP();
+	ASSERT_TRUE(first_dump->find("limited.*.__overflow__.counter") != first_dump->end());
+
+	// overflow metric is idle and gets evicted, registered metric is kept active
+	for (int i = 0; i < 20; ++i) {
+		HANDY_COUNTER_INCREMENT("limited.0", 1);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto idle_dump = HANDY_METRICS_DUMP();
+	ASSERT_TRUE(idle_dump->find("limited.*.__overflow__.counter") == idle_dump->end());
+
+	HANDY_COUNTER_INCREMENT("limited.2", 3);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	while (metrics_dump->find("limited.*.__overflow__.counter") == metrics_dump->end()) {
+		std::this_thread::sleep_for(std::chrono::microseconds(10));
+		metrics_dump = HANDY_METRICS_DUMP();
+	}
+
+	ASSERT_TRUE(metrics_dump->find("limited.2") == metrics_dump->end());
+
+	auto& overflow = boost::get<handystats::metrics::counter>(metrics_dump->at("limited.*.__overflow__.counter"));
+	ASSERT_EQ(overflow.values().get<handystats::statistics::tag::value>(), 3);
+}
@@ -0,0 +1,155 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "object_pool_impl.hpp"
+
+namespace {
+
+struct tracked {
+	static int alive;
+
+	std::string name;
+	double value;
+
+	tracked(const std::string& n, const double& v)
+		: name(n), value(v)
+	{
+		++alive;
+	}
+
+	~tracked() {
+		--alive;
+	}
+};
+
+int tracked::alive = 0;
+
+} // unnamed namespace
+
+TEST(ObjectPoolTest, ObjectsAreAllocatedContiguouslyAndReused) {
+	handystats::object_pool<tracked, 16> pool;
+
+	std::vector<tracked*> objects;
+	for (int index = 0; index < 16; ++index) {
+		objects.push_back(pool.create("object", index));
+	}
+
+	ASSERT_EQ(16, tracked::alive);
+	ASSERT_EQ(16, pool.size());
+	for (int index = 1; index < 16; ++index) {
+		ASSERT_EQ(
+				reinterpret_cast<char*>(objects[0]) + index * (reinterpret_cast<char*>(objects[1]) - reinterpret_cast<char*>(objects[0])),
+				reinterpret_cast<char*>(objects[index])
+			);
+		ASSERT_EQ(index, objects[index]->value);
+	}
+
+	tracked* freed = objects[5];
+	pool.destroy(freed);
+	ASSERT_EQ(15, tracked::alive);
+	ASSERT_EQ(15, pool.size());
+
+	tracked* reused = pool.create("reused", 100);
+	ASSERT_EQ(freed, reused);
+	objects[5] = reused;
+
+	// next chunk
+	tracked* extra = pool.create("extra", 16);
+	ASSERT_EQ(17, pool.size());
+	objects.push_back(extra);
+
+	for (auto object_iter = objects.begin(); object_iter != objects.end(); ++object_iter) {
+		pool.destroy(*object_iter);
+	}
+	ASSERT_EQ(0, tracked::alive);
+	ASSERT_EQ(0, pool.size());
+
+	pool.release();
+	ASSERT_EQ(0, pool.size());
+
+	tracked* after_release = pool.create("after", 0);
+	ASSERT_EQ(1, tracked::alive);
+	pool.destroy(after_release);
+}
+
+TEST(ObjectPoolTest, EmptyChunksAreReturned) {
+	handystats::object_pool<tracked, 16> pool;
+
+	std::vector<tracked*> objects;
+	for (int index = 0; index < 64; ++index) {
+		objects.push_back(pool.create("object", index));
+	}
+	ASSERT_EQ(4, pool.chunks());
+
+	// first two chunks become empty, the last one is still in use
+	for (int index = 0; index < 32; ++index) {
+		pool.destroy(objects[index]);
+	}
+	ASSERT_EQ(32, pool.size());
+	ASSERT_EQ(2, pool.chunks());
+
+	// partially freed chunk is reused before new chunk is allocated
+	tracked* freed = objects[40];
+	pool.destroy(freed);
+	objects[40] = pool.create("reused", 40);
+	ASSERT_EQ(freed, objects[40]);
+	ASSERT_EQ(2, pool.chunks());
+
+	// chunk allocations are served from is kept
+	for (int index = 32; index < 64; ++index) {
+		pool.destroy(objects[index]);
+	}
+	ASSERT_EQ(0, tracked::alive);
+	ASSERT_EQ(0, pool.size());
+	ASSERT_EQ(1, pool.chunks());
+}
+
+TEST(ObjectPoolTest, PoolAllocatorWithMap) {
+	typedef std::map<
+			std::string, int,
+			std::less<std::string>,
+			handystats::pool_allocator<std::pair<const std::string, int>>
+		>
+		map_type;
+
+	map_type pool_map;
+	std::map<std::string, int> reference_map;
+
+	for (int index = 0; index < 1000; ++index) {
+		const std::string key = "key." + std::to_string(index * 7919 % 1000);
+		pool_map[key] = index;
+		reference_map[key] = index;
+	}
+
+	for (int index = 0; index < 1000; index += 3) {
+		const std::string key = "key." + std::to_string(index);
+		pool_map.erase(key);
+		reference_map.erase(key);
+	}
+
+	ASSERT_EQ(reference_map.size(), pool_map.size());
+	ASSERT_TRUE(std::equal(reference_map.begin(), reference_map.end(), pool_map.begin()));
+
+	pool_map.clear();
+	ASSERT_TRUE(pool_map.empty());
+}
@@ -0,0 +1,144 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <string>
+#include <vector>
+#include <thread>
+
+#include <fnmatch.h>
+
+#include <gtest/gtest.h>
+
+#include "config/pattern_matcher_impl.hpp"
+
+using handystats::config::pattern_matcher;
+
+static const char* PATTERNS[] = {
+	"", "*", "?", "**", "a", "abc", "a*", "*c", "a*c", "a?c", "*b*", "a**c",
+	"a*b*c", "*.timer", "request.*.time", "request.?", "[abc]x", "[!abc]x", "[^a-c]x",
+	"[a-c-]", "[]]", "[!]]", "[]a]*", "x[", "x[ab", "[[]", "\\*", "a\\?c", "[\\]]",
+	"[[:digit:]]*", "[[:alpha:][:digit:]]", "*[[:upper:]]", "[z-a]", "[[:bogus:]]",
+	"[[=a=]]", "a\\", "*.*.*", "h*stats.*.c?unt*",
+};
+
+static const char* NAMES[] = {
+	"", "a", "b", "c", "ab", "abc", "abbc", "ac", "axc", "abcbc", "bx", "dx", "ax", "-", "]", "]abc",
+	"x[", "x[ab", "[", "*", "a?c", "a\\", "9lives", "Z", "z", "q9", "test.timer", "request.1.time",
+	"request.a.b.time", "request.x", "request.xy", "handystats.internal.count",
+	"handystats.a.counter", "handystats.a.count", "a.b.c", "..",
+};
+
+TEST(PatternMatcherTest, SinglePatternMatchesAsFnmatch) {
+	for (size_t pattern_index = 0; pattern_index < sizeof(PATTERNS) / sizeof(PATTERNS[0]); ++pattern_index) {
+		pattern_matcher matcher;
+		matcher.add(PATTERNS[pattern_index], 0);
+
+		for (size_t name_index = 0; name_index < sizeof(NAMES) / sizeof(NAMES[0]); ++name_index) {
+			const bool expected = fnmatch(PATTERNS[pattern_index], NAMES[name_index], 0) == 0;
+			ASSERT_EQ(expected, matcher.match(NAMES[name_index]) == 0)
+				<< "pattern '" << PATTERNS[pattern_index] << "' name '" << NAMES[name_index] << "'";
+		}
+	}
+}
+
+TEST(PatternMatcherTest, FirstMatchingPatternIsSelected) {
+	pattern_matcher matcher;
+	for (size_t pattern_index = 0; pattern_index < sizeof(PATTERNS) / sizeof(PATTERNS[0]); ++pattern_index) {
+		// reversed order of indices to check that pattern order does not matter
+		matcher.add(PATTERNS[pattern_index], sizeof(PATTERNS) / sizeof(PATTERNS[0]) - pattern_index);
+	}
+
+	// repeat to match against cached DFA states
+	for (int pass = 0; pass < 2; ++pass) {
+		for (size_t name_index = 0; name_index < sizeof(NAMES) / sizeof(NAMES[0]); ++name_index) {
+			size_t expected = pattern_matcher::npos;
+			for (size_t pattern_index = 0; pattern_index < sizeof(PATTERNS) / sizeof(PATTERNS[0]); ++pattern_index) {
+				if (fnmatch(PATTERNS[pattern_index], NAMES[name_index], 0) == 0) {
+					expected = std::min(expected, sizeof(PATTERNS) / sizeof(PATTERNS[0]) - pattern_index);
+				}
+			}
+			ASSERT_EQ(expected, matcher.match(NAMES[name_index])) << "name '" << NAMES[name_index] << "'";
+		}
+	}
+}
+
+TEST(PatternMatcherTest, ManyPatterns) {
+	pattern_matcher matcher;
+	ASSERT_TRUE(matcher.empty());
+
+	for (int index = 0; index < 5000; ++index) {
+		matcher.add("metric." + std::to_string(index) + ".*", index);
+	}
+	matcher.add("metric.*", 5000);
+
+	ASSERT_FALSE(matcher.empty());
+	ASSERT_EQ(0, matcher.match("metric.0.x"));
+	ASSERT_EQ(4999, matcher.match("metric.4999.timer"));
+	ASSERT_EQ(5000, matcher.match("metric.5000.timer"));
+	ASSERT_EQ(5000, matcher.match("metric.12"));
+	ASSERT_EQ(pattern_matcher::npos, matcher.match("other.12.x"));
+
+	matcher.clear();
+	ASSERT_TRUE(matcher.empty());
+	ASSERT_EQ(pattern_matcher::npos, matcher.match("metric.0.x"));
+}
+
+TEST(PatternMatcherTest, MatchesBeyondCachedStates) {
+	pattern_matcher matcher;
+	for (int index = 0; index < 5000; ++index) {
+		matcher.add("metric." + std::to_string(index) + ".*", index);
+	}
+
+	// distinct prefixes need more DFA states than are cached
+	for (int pass = 0; pass < 2; ++pass) {
+		for (int index = 0; index < 5000; ++index) {
+			ASSERT_EQ(index, matcher.match("metric." + std::to_string(index) + ".x"));
+		}
+	}
+}
+
+TEST(PatternMatcherTest, ConcurrentMatching) {
+	pattern_matcher matcher;
+	for (int index = 0; index < 100; ++index) {
+		matcher.add("request." + std::to_string(index) + ".*", index);
+	}
+	matcher.add("*.time", 100);
+
+	std::vector<std::thread> threads;
+	std::vector<int> mismatches(4, 0);
+	for (size_t thread_index = 0; thread_index < mismatches.size(); ++thread_index) {
+		threads.push_back(std::thread(
+				[&matcher, &mismatches, thread_index] () {
+					for (int index = 0; index < 2000; ++index) {
+						const int metric = (index * 7 + thread_index) % 150;
+						const size_t expected = metric < 100 ? metric : 100;
+						if (matcher.match("request." + std::to_string(metric) + ".time") != expected) {
+							++mismatches[thread_index];
+						}
+					}
+				}
+			));
+	}
+
+	for (auto thread_iter = threads.begin(); thread_iter != threads.end(); ++thread_iter) {
+		thread_iter->join();
+	}
+
+	for (size_t thread_index = 0; thread_index < mismatches.size(); ++thread_index) {
+		ASSERT_EQ(0, mismatches[thread_index]);
+	}
+}
@@ -0,0 +1,272 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <string>
+#include <thread>
+#include <map>
+#include <set>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <gtest/gtest.h>
+
+#include <handystats/core.hpp>
+#include <handystats/measuring_points.hpp>
+#include <handystats/metrics_dump.hpp>
+#include <handystats/prometheus_dump.hpp>
+
+#include <handystats/metrics/gauge.hpp>
+#include <handystats/metrics/counter.hpp>
+#include <handystats/metrics/timer.hpp>
+#include <handystats/metrics/attribute.hpp>
+
+#include "message_queue_helper.hpp"
+#include "metrics_dump_helper.hpp"
+
+using namespace handystats;
+
+static bool contains_line(const std::string& dump, const std::string& line) {
+	return ("\n" + dump).find("\n" + line + "\n") != std::string::npos;
+}
+
+TEST(PrometheusDumpTest, MetricTypesMapping) {
+	config::metrics::counter counter_opts;
+	counter_opts.values.tags = statistics::tag::value | statistics::tag::moving_avg;
+	metrics::counter counter(counter_opts);
+	counter.increment(10);
+
+	config::metrics::gauge gauge_opts;
+	gauge_opts.values.tags = statistics::tag::value | statistics::tag::histogram;
+	metrics::gauge gauge(gauge_opts);
+	for (int value = 1; value <= 100; ++value) {
+		gauge.set(value);
+	}
+
+	config::metrics::timer timer_opts;
+	timer_opts.values.tags = statistics::tag::quantile | statistics::tag::count | statistics::tag::sum | statistics::tag::max;
+	metrics::timer timer(timer_opts);
+	for (int value = 1; value <= 10; ++value) {
+		timer.set(chrono::duration(value, metrics::timer::value_unit));
+	}
+
+	metrics::attribute string_attr;
+	string_attr.set(std::string("a \"quoted\"\nvalue"));
+
+	metrics::attribute bool_attr;
+	bool_attr.set(true);
+
+	std::map<std::string, metrics::metric_variant> metrics_map;
+	metrics_map.insert(std::make_pair("test.counter", metrics::metric_variant(counter)));
+	metrics_map.insert(std::make_pair("test.gauge", metrics::metric_variant(gauge)));
+	metrics_map.insert(std::make_pair("1st-timer", metrics::metric_variant(timer)));
+	metrics_map.insert(std::make_pair("test.string", metrics::metric_variant(string_attr)));
+	metrics_map.insert(std::make_pair("test.bool", metrics::metric_variant(bool_attr)));
+
+	const std::string dump = prometheus::to_string(metrics_map);
+
+	// counters could be decremented, so they are not exposed as prometheus counters
+	ASSERT_TRUE(contains_line(dump, "# TYPE test_counter gauge"));
+	ASSERT_TRUE(contains_line(dump, "test_counter 10"));
+	ASSERT_TRUE(contains_line(dump, "# TYPE test_counter_moving_avg gauge"));
+
+	ASSERT_TRUE(contains_line(dump, "# TYPE test_gauge gauge"));
+	ASSERT_TRUE(contains_line(dump, "test_gauge 100"));
+	ASSERT_TRUE(contains_line(dump, "# TYPE test_gauge_histogram histogram"));
+	ASSERT_NE(dump.find("\ntest_gauge_histogram_bucket{le=\"+Inf\"} "), std::string::npos);
+	ASSERT_NE(dump.find("\ntest_gauge_histogram_count "), std::string::npos);
+
+	ASSERT_TRUE(contains_line(dump, "# TYPE _1st_timer summary"));
+	ASSERT_NE(dump.find("\n_1st_timer{quantile=\"0.5\"} "), std::string::npos);
+	ASSERT_NE(dump.find("\n_1st_timer{quantile=\"0.95\"} "), std::string::npos);
+	ASSERT_TRUE(contains_line(dump, "_1st_timer_sum 55"));
+	ASSERT_TRUE(contains_line(dump, "_1st_timer_count 10"));
+	ASSERT_TRUE(contains_line(dump, "# TYPE _1st_timer_max gauge"));
+	ASSERT_TRUE(contains_line(dump, "_1st_timer_max 10"));
+	ASSERT_EQ(dump.find("# TYPE _1st_timer_sum"), std::string::npos);
+
+	ASSERT_TRUE(contains_line(dump, "# TYPE test_string_info gauge"));
+	ASSERT_TRUE(contains_line(dump, "test_string_info{value=\"a \\\"quoted\\\"\\nvalue\"} 1"));
+
+	ASSERT_TRUE(contains_line(dump, "test_bool 1"));
+
+	// histogram buckets are cumulative (bin counts are subject to moving interval decay)
+	double last_bucket = 0;
+	size_t pos = 0;
+	while ((pos = dump.find("test_gauge_histogram_bucket{le=", pos)) != std::string::npos) {
+		const size_t value_pos = dump.find("} ", pos) + 2;
+		const double bucket = strtod(dump.c_str() + value_pos, nullptr);
+		ASSERT_GE(bucket, last_bucket);
+		last_bucket = bucket;
+		pos = value_pos;
+	}
+	const size_t count_pos = dump.find("\ntest_gauge_histogram_count ") + strlen("\ntest_gauge_histogram_count ");
+	ASSERT_NEAR(last_bucket, strtod(dump.c_str() + count_pos, nullptr), 1E-9);
+	ASSERT_GT(last_bucket, 0);
+}
+
+TEST(PrometheusDumpTest, CollidingNamesAreExposedOnce) {
+	config::metrics::gauge gauge_opts;
+	gauge_opts.values.tags = statistics::tag::value;
+
+	metrics::gauge first_gauge(gauge_opts);
+	first_gauge.set(1);
+	metrics::gauge second_gauge(gauge_opts);
+	second_gauge.set(2);
+
+	config::metrics::timer timer_opts;
+	timer_opts.values.tags = statistics::tag::quantile | statistics::tag::count | statistics::tag::sum;
+	metrics::timer timer(timer_opts);
+	timer.set(chrono::duration(1, metrics::timer::value_unit));
+
+	std::map<std::string, metrics::metric_variant> metrics_map;
+	metrics_map.insert(std::make_pair("a.b", metrics::metric_variant(first_gauge)));
+	metrics_map.insert(std::make_pair("a_b", metrics::metric_variant(second_gauge)));
+	metrics_map.insert(std::make_pair("x", metrics::metric_variant(timer)));
+	metrics_map.insert(std::make_pair("x.count", metrics::metric_variant(second_gauge)));
+	metrics_map.insert(std::make_pair("y", metrics::metric_variant(first_gauge)));
+
+	// "-9_max" is exposed as "_9_max" before "9" (exposed as "_9" with "_9_max" gauge)
+	config::metrics::gauge max_gauge_opts;
+	max_gauge_opts.values.tags = statistics::tag::value | statistics::tag::max;
+	metrics::gauge max_gauge(max_gauge_opts);
+	max_gauge.set(3);
+	metrics_map.insert(std::make_pair("-9_max", metrics::metric_variant(second_gauge)));
+	metrics_map.insert(std::make_pair("9", metrics::metric_variant(max_gauge)));
+
+	const std::string dump = prometheus::to_string(metrics_map);
+
+	// "a.b" is written first ("a.b" < "a_b"), "a_b" is skipped
+	ASSERT_TRUE(contains_line(dump, "# TYPE a_b gauge"));
+	ASSERT_TRUE(contains_line(dump, "a_b 1"));
+	ASSERT_EQ(dump.find("a_b 2"), std::string::npos);
+	ASSERT_EQ(dump.find("# TYPE a_b gauge"), dump.rfind("# TYPE a_b gauge"));
+
+	// x_count sample of "x" summary is not repeated by "x.count" gauge
+	ASSERT_TRUE(contains_line(dump, "# TYPE x summary"));
+	ASSERT_TRUE(contains_line(dump, "x_count 1"));
+	ASSERT_EQ(dump.find("# TYPE x_count"), std::string::npos);
+	ASSERT_EQ(dump.find("x_count 2"), std::string::npos);
+
+	// metric is skipped as a whole if any of its suffixed names collides
+	ASSERT_TRUE(contains_line(dump, "_9_max 2"));
+	ASSERT_EQ(dump.find("_9 3"), std::string::npos);
+	ASSERT_EQ(dump.find("_9_max 3"), std::string::npos);
+
+	// metrics after skipped ones are written
+	ASSERT_TRUE(contains_line(dump, "# TYPE y gauge"));
+	ASSERT_TRUE(contains_line(dump, "y 1"));
+}
+
+TEST(PrometheusDumpTest, ServedOverHttp) {
+	HANDY_CONFIG_JSON(
+			"{\
+				\"dump-interval\": 1,\
+				\"dump-formats\": [\"json\", \"prometheus\"]\
+			}"
+		);
+
+	HANDY_INIT();
+
+	for (int i = 0; i < 10; ++i) {
+		HANDY_TIMER_START("test.timer");
+		HANDY_GAUGE_SET("test.gauge", i);
+		HANDY_COUNTER_INCREMENT("test.counter", i);
+		HANDY_TIMER_STOP("test.timer");
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	// local HTTP stand-in for Prometheus endpoint
+	const int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	ASSERT_GE(listen_fd, 0);
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	ASSERT_EQ(0, bind(listen_fd, (sockaddr*)&addr, sizeof(addr)));
+	ASSERT_EQ(0, listen(listen_fd, 1));
+
+	socklen_t addr_len = sizeof(addr);
+	ASSERT_EQ(0, getsockname(listen_fd, (sockaddr*)&addr, &addr_len));
+
+	auto served_dump = HANDY_PROMETHEUS_DUMP_SHARED();
+
+	std::thread server(
+			[&] () {
+				const int conn_fd = accept(listen_fd, nullptr, nullptr);
+				if (conn_fd < 0) {
+					return;
+				}
+
+				char request[1024];
+				if (read(conn_fd, request, sizeof(request)) > 0) {
+					const std::string header = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n\r\n";
+					if (write(conn_fd, header.data(), header.size()) == ssize_t(header.size())) {
+						write(conn_fd, served_dump->data(), served_dump->size());
+					}
+				}
+				close(conn_fd);
+			}
+		);
+
+	const int client_fd = socket(AF_INET, SOCK_STREAM, 0);
+	ASSERT_GE(client_fd, 0);
+	ASSERT_EQ(0, connect(client_fd, (sockaddr*)&addr, sizeof(addr)));
+
+	const std::string request = "GET /metrics HTTP/1.0\r\n\r\n";
+	ASSERT_EQ(ssize_t(request.size()), write(client_fd, request.data(), request.size()));
+
+	std::string response;
+	char chunk[4096];
+	ssize_t res;
+	while ((res = read(client_fd, chunk, sizeof(chunk))) > 0) {
+		response.append(chunk, res);
+	}
+
+	close(client_fd);
+	server.join();
+	close(listen_fd);
+
+	const size_t body_pos = response.find("\r\n\r\n");
+	ASSERT_NE(body_pos, std::string::npos);
+	const std::string body = response.substr(body_pos + 4);
+
+	ASSERT_EQ(*served_dump, body);
+
+	ASSERT_TRUE(contains_line(body, "# TYPE test_gauge gauge"));
+	ASSERT_TRUE(contains_line(body, "# TYPE test_counter gauge"));
+	ASSERT_TRUE(contains_line(body, "# TYPE handystats_message_queue_size gauge"));
+	ASSERT_NE(body.find("\ntest_timer_value "), std::string::npos);
+
+	// each family is exposed once
+	std::set<std::string> families;
+	size_t line_pos = 0;
+	while ((line_pos = body.find("# TYPE ", line_pos)) != std::string::npos) {
+		const size_t name_pos = line_pos + strlen("# TYPE ");
+		const size_t name_end = body.find(' ', name_pos);
+		ASSERT_TRUE(families.insert(body.substr(name_pos, name_end - name_pos)).second);
+		line_pos = name_end;
+	}
+
+	HANDY_FINALIZE();
+}
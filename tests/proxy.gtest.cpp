@@ -182,3 +182,43 @@ TEST_F(HandyProxyTest, TimerProxyMultiInstance) {
 				handystats::chrono::duration(sleep_interval.count(), handystats::chrono::time_unit::MSEC)).count()
 		);
 }
+
+TEST_F(HandyProxyTest, TimerProxyLocalMeasurement) {
+	const char* timer_name = "timer";
+	const std::chrono::milliseconds sleep_interval(1);
+	const size_t SLEEP_COUNT = 10;
+
+	handystats::measuring_points::timer_proxy timer_proxy(timer_name,
+			handystats::measuring_points::timer_proxy::measurement_mode::LOCAL
+		);
+
+	for (size_t sleep_step = 0; sleep_step < SLEEP_COUNT; ++sleep_step) {
+		timer_proxy.start();
+		std::this_thread::sleep_for(sleep_interval);
+		timer_proxy.stop();
+	}
+
+	// discarded and not started measurements are not passed
+	timer_proxy.start();
+	timer_proxy.discard();
+	timer_proxy.stop();
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	auto metrics_dump = HANDY_METRICS_DUMP();
+	ASSERT_TRUE(metrics_dump->find(timer_name) != metrics_dump->end());
+
+	auto& timer = boost::get<handystats::metrics::timer>(metrics_dump->at(timer_name));
+
+	ASSERT_EQ(timer.values().get<handystats::statistics::tag::count>(), SLEEP_COUNT);
+	ASSERT_GE(
+			timer.values().get<handystats::statistics::tag::min>(),
+			handystats::chrono::duration::convert_to(handystats::metrics::timer::value_unit,
+				handystats::chrono::duration(sleep_interval.count(), handystats::chrono::time_unit::MSEC)).count()
+		);
+
+	// single set event per measurement
+	auto& pop_count = boost::get<handystats::metrics::counter>(metrics_dump->at("handystats.message_queue.pop_count"));
+	ASSERT_EQ(pop_count.values().get<handystats::statistics::tag::value>(), SLEEP_COUNT);
+}
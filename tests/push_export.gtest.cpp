@@ -0,0 +1,245 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <string>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cstring>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <gtest/gtest.h>
+
+#include <handystats/core.hpp>
+#include <handystats/measuring_points.hpp>
+#include <handystats/metrics_dump.hpp>
+#include <handystats/binary_dump.hpp>
+
+#include "message_queue_helper.hpp"
+#include "metrics_dump_helper.hpp"
+
+static std::string socket_path() {
+	std::ostringstream path;
+	path << "/tmp/handystats-push-export-test-" << getpid() << ".sock";
+	return path.str();
+}
+
+static int listen_unix(const std::string& path) {
+	unlink(path.c_str());
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 1) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static bool read_exact(const int& fd, char* data, size_t size) {
+	while (size > 0) {
+		pollfd pfd = {fd, POLLIN, 0};
+		if (poll(&pfd, 1, 5000) <= 0) {
+			return false;
+		}
+		const ssize_t res = read(fd, data, size);
+		if (res <= 0) {
+			return false;
+		}
+		data += res;
+		size -= res;
+	}
+	return true;
+}
+
+static uint64_t dropped_count() {
+	auto dump = HANDY_METRICS_DUMP();
+	auto dropped_iter = dump->find("handystats.push_export.dropped_count");
+	if (dropped_iter == dump->end()) {
+		return 0;
+	}
+	return boost::get<handystats::metrics::counter>(dropped_iter->second).values().get<handystats::statistics::tag::value>();
+}
+
+TEST(PushExportTest, UnixSocketFrames) {
+	const int listen_fd = listen_unix(socket_path());
+	ASSERT_GE(listen_fd, 0);
+
+	std::ostringstream config;
+	config << "{\"dump-interval\": 10, \"push-export\": {\"address\": \"unix:" << socket_path() << "\"}}";
+	HANDY_CONFIG_JSON(config.str().c_str());
+
+	HANDY_INIT();
+
+	HANDY_GAUGE_SET("test.gauge", 42);
+
+	const int conn_fd = accept(listen_fd, nullptr, nullptr);
+	ASSERT_GE(conn_fd, 0);
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	// frames are read until the one containing the gauge
+	bool found = false;
+	for (int frame = 0; frame < 100 && !found; ++frame) {
+		unsigned char size_data[4];
+		ASSERT_TRUE(read_exact(conn_fd, (char*)size_data, 4));
+		const size_t size = size_data[0] | (size_data[1] << 8) | (size_data[2] << 16) | (size_data[3] << 24);
+
+		std::string data(size, '\0');
+		ASSERT_TRUE(read_exact(conn_fd, &data[0], size));
+
+		handystats::binary::snapshot snapshot;
+		ASSERT_TRUE(handystats::binary::decode(data, snapshot));
+
+		auto gauge_iter = snapshot.metrics.find("test.gauge");
+		if (gauge_iter != snapshot.metrics.end()) {
+			ASSERT_EQ(42, gauge_iter->second.value);
+			found = true;
+		}
+	}
+	ASSERT_TRUE(found);
+
+	HANDY_FINALIZE();
+
+	close(conn_fd);
+	close(listen_fd);
+	unlink(socket_path().c_str());
+}
+
+TEST(PushExportTest, UdpStatsdLines) {
+	const int udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+	ASSERT_GE(udp_fd, 0);
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	ASSERT_EQ(0, bind(udp_fd, (sockaddr*)&address, sizeof(address)));
+
+	socklen_t address_size = sizeof(address);
+	ASSERT_EQ(0, getsockname(udp_fd, (sockaddr*)&address, &address_size));
+
+	std::ostringstream config;
+	config << "{\"dump-interval\": 10, \"push-export\": {\"address\": \"udp:127.0.0.1:" << ntohs(address.sin_port) << "\", \"max-datagram-size\": 128},"
+		<< "\"dump-filter\": {\"test.hidden\": [\"count\"]}}";
+	HANDY_CONFIG_JSON(config.str().c_str());
+
+	HANDY_INIT();
+
+	HANDY_GAUGE_SET("test.gauge", 42);
+	HANDY_GAUGE_SET("test.hidden", 1);
+	HANDY_TIMER_SET("test.timer", handystats::chrono::duration(3, handystats::chrono::time_unit::MSEC));
+
+	bool gauge_found = false;
+	bool timer_found = false;
+	bool hidden_found = false;
+	for (int datagram = 0; datagram < 1000 && !(gauge_found && timer_found); ++datagram) {
+		pollfd pfd = {udp_fd, POLLIN, 0};
+		ASSERT_GT(poll(&pfd, 1, 5000), 0);
+
+		char data[2048];
+		const ssize_t size = recv(udp_fd, data, sizeof(data), 0);
+		ASSERT_GT(size, 0);
+		ASSERT_LE(size, 128);
+
+		const std::string lines = "\n" + std::string(data, size) + "\n";
+		gauge_found = gauge_found || lines.find("\ntest.gauge:42|g\n") != std::string::npos;
+		timer_found = timer_found || lines.find("\ntest.timer:3|ms\n") != std::string::npos;
+		hidden_found = hidden_found || lines.find("\ntest.hidden:") != std::string::npos;
+	}
+	ASSERT_TRUE(gauge_found);
+	ASSERT_TRUE(timer_found);
+	// value is excluded by dump-filter
+	ASSERT_FALSE(hidden_found);
+
+	HANDY_FINALIZE();
+
+	close(udp_fd);
+}
+
+TEST(PushExportTest, SlowCollectorDoesNotStallDumps) {
+	// collector never accepts connection
+	const int listen_fd = listen_unix(socket_path());
+	ASSERT_GE(listen_fd, 0);
+
+	std::ostringstream config;
+	config << "{\"dump-interval\": 1, \"push-export\": {\"address\": \"unix:" << socket_path() << "\", \"buffer-size\": 1024}}";
+	HANDY_CONFIG_JSON(config.str().c_str());
+
+	HANDY_INIT();
+
+	for (int i = 0; i < 100; ++i) {
+		HANDY_GAUGE_SET(("test.gauge.%d", i), i);
+	}
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (dropped_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+		handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+	}
+
+	ASSERT_GT(dropped_count(), 0);
+
+	// dumps keep going
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	HANDY_FINALIZE();
+
+	close(listen_fd);
+	unlink(socket_path().c_str());
+}
+
+TEST(PushExportTest, FramesAboveBufferSizeAreDropped) {
+	const int listen_fd = listen_unix(socket_path());
+	ASSERT_GE(listen_fd, 0);
+
+	// any dump is larger than buffer
+	std::ostringstream config;
+	config << "{\"dump-interval\": 1, \"push-export\": {\"address\": \"unix:" << socket_path() << "\", \"buffer-size\": 16}}";
+	HANDY_CONFIG_JSON(config.str().c_str());
+
+	HANDY_INIT();
+
+	const int conn_fd = accept(listen_fd, nullptr, nullptr);
+	ASSERT_GE(conn_fd, 0);
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (dropped_count() < 3 && std::chrono::steady_clock::now() < deadline) {
+		handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+	}
+	ASSERT_GE(dropped_count(), 3);
+
+	// nothing is sent
+	pollfd pfd = {conn_fd, POLLIN, 0};
+	ASSERT_EQ(0, poll(&pfd, 1, 0));
+
+	HANDY_FINALIZE();
+
+	close(conn_fd);
+	close(listen_fd);
+	unlink(socket_path().c_str());
+}
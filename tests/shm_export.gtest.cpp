@@ -0,0 +1,209 @@
+/*
+* Copyright (c) YANDEX LLC. All rights reserved.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library.
+*/
+
+#include <string>
+#include <sstream>
+
+#include <new>
+#include <cstring>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <gtest/gtest.h>
+
+#include <handystats/core.hpp>
+#include <handystats/measuring_points.hpp>
+#include <handystats/metrics_dump.hpp>
+#include <handystats/binary_dump.hpp>
+#include <handystats/shm_export.hpp>
+
+#include "message_queue_helper.hpp"
+#include "metrics_dump_helper.hpp"
+
+static std::string segment_name() {
+	std::ostringstream name;
+	name << "/handystats-shm-export-test-" << getpid();
+	return name.str();
+}
+
+static void configure(const size_t& size, const size_t& dump_interval, const std::string& name = segment_name()) {
+	std::ostringstream config;
+	config << "{"
+		<< "\"dump-interval\": " << dump_interval << ","
+		<< "\"shm-export\": {\"name\": \"" << name << "\", \"size\": " << size << "}"
+		<< "}";
+	HANDY_CONFIG_JSON(config.str().c_str());
+}
+
+// creates segment as if it was exported by process with given pid
+static void create_segment(const std::string& name, const pid_t& pid) {
+	const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(0, ftruncate(fd, sizeof(handystats::shm_export::segment_header)));
+
+	void* data = mmap(nullptr, sizeof(handystats::shm_export::segment_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	ASSERT_NE(MAP_FAILED, data);
+
+	auto* hdr = new (data) handystats::shm_export::segment_header();
+	memcpy(hdr->magic, handystats::shm_export::MAGIC, sizeof(handystats::shm_export::MAGIC));
+	hdr->version = handystats::shm_export::VERSION;
+	hdr->header_size = sizeof(handystats::shm_export::segment_header);
+	hdr->pid = pid;
+	hdr->capacity.store(0);
+	hdr->generation.store(0);
+	hdr->size.store(0);
+	hdr->sequence.store(0);
+
+	munmap(data, sizeof(handystats::shm_export::segment_header));
+	close(fd);
+}
+
+// pid of exited process
+static pid_t dead_pid() {
+	const pid_t pid = fork();
+	if (pid == 0) {
+		_exit(0);
+	}
+	waitpid(pid, nullptr, 0);
+	return pid;
+}
+
+static void publish_dump() {
+	HANDY_GAUGE_SET("test.gauge", 1);
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+}
+
+TEST(ShmExportTest, ReaderSeesPublishedDump) {
+	configure(1 << 20, 1);
+
+	HANDY_INIT();
+
+	for (int i = 0; i < 10; ++i) {
+		HANDY_GAUGE_SET("test.gauge", i);
+		HANDY_COUNTER_INCREMENT("test.counter", i);
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	handystats::shm_export::reader reader(segment_name());
+	ASSERT_TRUE(reader.valid());
+
+	std::string data;
+	uint64_t generation = 0;
+	ASSERT_TRUE(reader.read(data, &generation));
+	ASSERT_GT(generation, 0);
+
+	handystats::binary::snapshot snapshot;
+	ASSERT_TRUE(handystats::binary::decode(data, snapshot));
+	ASSERT_TRUE(snapshot.metrics.find("test.gauge") != snapshot.metrics.end());
+	ASSERT_TRUE(snapshot.metrics.find("test.counter") != snapshot.metrics.end());
+	ASSERT_EQ(9, snapshot.metrics.at("test.gauge").value);
+
+	HANDY_FINALIZE();
+
+	ASSERT_FALSE(handystats::shm_export::reader(segment_name()).valid());
+}
+
+TEST(ShmExportTest, SegmentGrowsForLargeDump) {
+	configure(16, 100);
+
+	HANDY_INIT();
+
+	handystats::shm_export::reader reader(segment_name());
+	ASSERT_TRUE(reader.valid());
+
+	for (int i = 0; i < 1000; ++i) {
+		HANDY_GAUGE_SET(("test.gauge.%d", i), i);
+	}
+
+	handystats::message_queue::wait_until_empty();
+	handystats::metrics_dump::wait_until(handystats::chrono::system_clock::now());
+
+	std::string data;
+	ASSERT_TRUE(reader.read(data));
+
+	handystats::binary::snapshot snapshot;
+	ASSERT_TRUE(handystats::binary::decode(data, snapshot));
+	ASSERT_TRUE(snapshot.metrics.find("test.gauge.999") != snapshot.metrics.end());
+
+	HANDY_FINALIZE();
+}
+
+TEST(ShmExportTest, NameIsExpandedWithPid) {
+	ASSERT_EQ("/handystats-42", handystats::shm_export::expand_name("/handystats-%p", 42));
+	ASSERT_EQ("/handystats-%p-42", handystats::shm_export::expand_name("/handystats-%%p-%p", 42));
+	ASSERT_EQ(segment_name(), handystats::shm_export::expand_name("/handystats-shm-export-test-%p", getpid()));
+
+	configure(1 << 20, 1, "/handystats-shm-export-test-%p");
+
+	HANDY_INIT();
+
+	publish_dump();
+
+	handystats::shm_export::reader reader(segment_name());
+	ASSERT_TRUE(reader.valid());
+
+	std::string data;
+	ASSERT_TRUE(reader.read(data));
+
+	HANDY_FINALIZE();
+}
+
+TEST(ShmExportTest, SegmentOfLiveProcessIsNotReplaced) {
+	create_segment(segment_name(), getppid());
+
+	configure(1 << 20, 1);
+
+	HANDY_INIT();
+
+	publish_dump();
+
+	// segment is left untouched, nothing is published into it
+	handystats::shm_export::reader reader(segment_name());
+	ASSERT_TRUE(reader.valid());
+
+	std::string data;
+	ASSERT_FALSE(reader.read(data));
+
+	HANDY_FINALIZE();
+
+	ASSERT_TRUE(handystats::shm_export::reader(segment_name()).valid());
+	shm_unlink(segment_name().c_str());
+}
+
+TEST(ShmExportTest, StaleSegmentIsReplaced) {
+	create_segment(segment_name(), dead_pid());
+
+	configure(1 << 20, 1);
+
+	HANDY_INIT();
+
+	publish_dump();
+
+	handystats::shm_export::reader reader(segment_name());
+	ASSERT_TRUE(reader.valid());
+
+	std::string data;
+	ASSERT_TRUE(reader.read(data));
+
+	HANDY_FINALIZE();
+}